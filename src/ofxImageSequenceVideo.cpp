@@ -7,18 +7,35 @@
 //
 
 #include "ofxImageSequenceVideo.h"
+#include "ofxImageSequenceVideoPageCache.h"
 #include "ofxTimeMeasurements.h"
 #include "../lib/stb/stb_image.h"
-
-#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
-	#include <getopt.h>
-	#include <dirent.h>
-#else
-	#include <dirent_vs.h>
+#if defined(USE_TURBO_JPEG)
+	#include "turbojpeg.h"
 #endif
 
-
-#define CURRENT_FRAME_ALT frames[currentFrameSet]
+bool ofxImageSequenceVideo::useDirectoryManifests = false;
+string ofxImageSequenceVideo::directoryManifestsDir;
+
+//per thread buffers - encoded bytes of the frame being loaded (they grow to the largest frame, and are reused from
+//then on), and the post decode stage's, see finishFrame()
+static thread_local ofBuffer encodedFrame;
+static thread_local ofPixels decodedFrame;
+static thread_local ofPixels scaledFrame;
+
+#if defined(USE_TURBO_JPEG)
+//one decompressor per thread, created on its 1st jpg and reused for the life of the thread; a handle can't be shared
+//between threads, and creating / destroying one per frame is a measurable part of a small frame's decode time
+struct TurboJpegDecoder{
+	tjhandle handle = nullptr;
+	~TurboJpegDecoder(){ if(handle) tjDestroy(handle); }
+	tjhandle get(){
+		if(!handle) handle = tjInitDecompress();
+		return handle;
+	}
+};
+static thread_local TurboJpegDecoder turboJpegDecoder;
+#endif
 
 // In order to avoid duplicate symbol errors with other addons that use stb_image,
 // stb image implementations will not be automatically included. In order to include
@@ -55,14 +72,62 @@ ofxImageSequenceVideo::ofxImageSequenceVideo(){}
 
 ofxImageSequenceVideo::~ofxImageSequenceVideo(){
 
-	//wait for all threads to end
-	for(int i = tasks.size() - 1; i >= 0; i--){
-		std::future_status status = tasks[i].wait_for(std::chrono::microseconds(0));
-		while(status != std::future_status::ready){
-			ofSleepMillis(1);
-			status = tasks[i].wait_for(std::chrono::microseconds(0));
-		}
+	releaseThreadPool();
+}
+
+
+void ofxImageSequenceVideo::releaseThreadPool(){
+	if(!threadPool) return;
+	if(ioPool || uringReader){ //unblock I/O threads waiting on the bounded queue, and stop queueing decodes
+		std::lock_guard<std::mutex> lock(pipelineMutex);
+		pipelineShuttingDown = true;
+	}
+	pipelineCondition.notify_all();
+	if(uringReader){
+		uringReader->stop(); //drops the queued reads, and waits for the batch being read
+		uringReader.reset();
 	}
+	if(ioPool){ //drop the I/O threads' work
+		ioPool->cancelJobs(ioPoolClientID);
+		ioPool->waitForClient(ioPoolClientID); //after this, no more decode jobs will be submitted
+		ioPool->removeClient(ioPoolClientID);
+		ioPool.reset();
+		ioPoolClientID = -1;
+	}
+	//drop our queued jobs, and wait for the running ones to end
+	threadPool->cancelJobs(threadPoolClientID);
+	threadPool->waitForClient(threadPoolClientID);
+	LoadResults results;
+	while(completedTasks.pop(results)){} //discard results, we are tearing down
+	numTasksInFlight = 0;
+	threadPool->removeClient(threadPoolClientID);
+	threadPool.reset(); //if we own the pool, this joins its (by now idle) threads
+	threadPoolClientID = -1;
+	numQueuedDecodes = 0; //cancelled decodes never got to take themselves off the queue
+	pipelineShuttingDown = false;
+}
+
+
+void ofxImageSequenceVideo::setUseIoUring(bool use, bool directIO){
+	useIoUring = use;
+	ioUringDirectIO = directIO;
+}
+
+
+void ofxImageSequenceVideo::setPipelineThreads(int numIoThreads, int maxQueuedDecodes){
+	this->numIoThreads = MAX(0, numIoThreads);
+	this->maxQueuedDecodes = MAX(1, maxQueuedDecodes);
+}
+
+
+void ofxImageSequenceVideo::setupSharedScheduler(int numThreads){
+	ofxImageSequenceVideoThreadPool::shared(numThreads);
+}
+
+
+float ofxImageSequenceVideo::getSchedulerShare(){
+	if(!threadPool) return 0.0f;
+	return threadPool->getClientShare(threadPoolClientID);
 }
 
 
@@ -72,92 +137,573 @@ void ofxImageSequenceVideo::setup(int numThreads, int bufferSize, bool useDXTcom
 	this->keepTexturesInGpuMem = false;
 	this->useDXTCompression = useDXTcompression;
     this->reverse = _reverse;
+
+	if(threadPool){ //let in-flight work finish so that frame states stay consistent
+		if(uringReader) uringReader->waitUntilIdle(); //reads first, they feed the decoders
+		if(ioPool) ioPool->waitForClient(ioPoolClientID);
+		threadPool->waitForClient(threadPoolClientID);
+		if(loaded) handleThreadCleanup();
+	}
+	releaseThreadPool();
+	pixelPool.setMaxBuffers(numThreads + 2); //in steady state, only a couple of buffers are free at any time
+	if(numThreads > 0){
+		if(useSharedScheduler){
+			threadPool = ofxImageSequenceVideoThreadPool::shared();
+		}else{
+			threadPool = std::make_shared<ofxImageSequenceVideoThreadPool>(numThreads);
+		}
+		threadPoolClientID = threadPool->addClient();
+		if(useIoUring && !useDXTCompression){
+			uringReader = std::make_unique<ofxImageSequenceVideoUringReader>(MAX(32, 2 * (numThreads + maxQueuedDecodes)), ioUringDirectIO);
+			if(!uringReader->isAvailable()) uringReader.reset(); //falls back to I/O threads, or to plain loading
+		}
+		if(numIoThreads > 0 && !uringReader){
+			ioPool = std::make_shared<ofxImageSequenceVideoThreadPool>(numIoThreads);
+			ioPoolClientID = ioPool->addClient();
+		}
+	}
 }
 
 
 
-static const char *get_filename_extension(const char *filename) {
-	const char *dot = strrchr(filename, '.');
-	if(!dot || dot == filename) return "";
-	return dot + 1;
+vector<string> ofxImageSequenceVideo::getImagesAtDirectory(const string & path, bool useDxtCompression){
+
+	string fullPath = ofToDataPath(path, true);
+	vector<string> imageTypes;
+	if(!useDxtCompression){
+		imageTypes = ofxImageSequenceVideo::getSupportedImageTypes();
+	}else{
+		imageTypes = {"dxt"};
+	}
+	string manifestPath;
+	if(useDirectoryManifests){
+		manifestPath = ofxImageSequenceVideoDirectory::getManifestPath(fullPath, directoryManifestsDir);
+	}
+	return ofxImageSequenceVideoDirectory::listFiles(fullPath, imageTypes, manifestPath);
 }
 
 
-vector<string> ofxImageSequenceVideo::getImagesAtDirectory(const string & path, bool useDxtCompression){
+void ofxImageSequenceVideo::setUseDirectoryManifests(bool use, const string & cacheDir){
+	useDirectoryManifests = use;
+	directoryManifestsDir = cacheDir.size() ? ofToDataPath(cacheDir, true) : "";
+}
 
-	DIR *dir2;
-	struct dirent *ent;
-	vector<string> fileNames;
-	string fullPath = ofToDataPath(path,true);
 
-	const auto imageTypes = ofxImageSequenceVideo::getSupportedImageTypes();
+bool ofxImageSequenceVideo::packImageSequence(const string & dirPath, const string & isvPath){
 
-	if ((dir2 = opendir(fullPath.c_str()) ) != NULL) {
+	vector<string> fileNames = ofxImageSequenceVideo::getImagesAtDirectory(dirPath, false);
+	if(fileNames.empty()) fileNames = ofxImageSequenceVideo::getImagesAtDirectory(dirPath, true); //a DXT sequence then
+	vector<string> filePaths;
+	for(auto & f : fileNames){
+		filePaths.push_back(dirPath + "/" + f);
+	}
+	return ofxImageSequenceVideoPackedFile::write(filePaths, isvPath);
+}
 
-		while ((ent = readdir (dir2)) != NULL) {
-			string ext = string(get_filename_extension(ent->d_name));
-			bool isVisible = ent->d_name[0] != '.';
-			bool isCompatibleType;
-			if(!useDxtCompression){
-				isCompatibleType = std::find(imageTypes.begin(), imageTypes.end(), ext ) != imageTypes.end();
-			}else{
-				isCompatibleType = ext == "dxt";
-			}
-			if ( isVisible && isCompatibleType ){
-				fileNames.push_back(string(ent->d_name));
-			}
+
+bool ofxImageSequenceVideo::loadImageSequence(const string & path, float frameRate){
+
+	Sequence seq;
+	if(!openSequence(path, frameRate, seq)){
+		loaded = false;
+		return false;
+	}
+	ofLogVerbose("ofxImageSequenceVideo") << "loadImageSequence() \"" << path << "\"";
+	clearQueuedSequence();
+	playlist.clear();
+	setupFrames(seq, false);
+	startLoading();
+	return true;
+}
+
+
+bool ofxImageSequenceVideo::loadImageSequence(const string & pattern, int firstFrame, int lastFrame, float frameRate){
+
+	Sequence seq;
+	if(!openSequence(pattern, firstFrame, lastFrame, frameRate, seq)){
+		loaded = false;
+		return false;
+	}
+	ofLogVerbose("ofxImageSequenceVideo") << "loadImageSequence() \"" << pattern << "\" [" << firstFrame << ".." << lastFrame << "]";
+	clearQueuedSequence();
+	playlist.clear();
+	setupFrames(seq, false);
+	startLoading();
+	return true;
+}
+
+
+bool ofxImageSequenceVideo::loadImageSequence(const vector<string> & directories, float frameRate){
+
+	Sequence seq;
+	if(!openSequence(directories, frameRate, seq)){
+		loaded = false;
+		return false;
+	}
+	ofLogVerbose("ofxImageSequenceVideo") << "loadImageSequence() " << directories.size() << " directories, \"" << seq.path << "\"...";
+	clearQueuedSequence();
+	playlist.clear();
+	setupFrames(seq, false);
+	startLoading();
+	return true;
+}
+
+
+bool ofxImageSequenceVideo::openSequence(const string & path, float frameRate, Sequence & seq){
+
+	if(!ofxImageSequenceVideoPackedFile::isPackedFile(path)){
+		return openSequence(vector<string>{path}, frameRate, seq);
+	}
+
+	auto packed = std::make_shared<ofxImageSequenceVideoPackedFile>();
+	int num = packed->open(path) ? packed->getNumFrames() : 0;
+	if(num < 2){
+		ofLogError("ofxImageSequenceVideo") << "can't open image sequence! Not enough image files in \"" << path << "\"";
+		return false;
+	}
+	if(packed->isDXT() != useDXTCompression){
+		ofLogError("ofxImageSequenceVideo") << "can't open \"" << path << "\"! " << (useDXTCompression ?
+			"It doesn't hold DXT frames, and the player was setup() with useDXTcompression" :
+			"It holds DXT frames, setup() the player with useDXTcompression to play it");
+		return false;
+	}
+
+	seq.table = std::make_shared<FrameTable>();
+	seq.table->setup(num);
+	seq.packed = packed;
+	seq.pattern.reset();
+	seq.path = path;
+	seq.frameRate = frameRate;
+	auto & ext = seq.table->fileExtension; //frames live inside the packed file, no paths
+	ext = packed->getFileExtension();
+	std::transform(ext.begin(), ext.end(), ext.begin(), ofxImageSequenceVideo::asciitolower); //convert to lowercase
+	return true;
+}
+
+
+bool ofxImageSequenceVideo::openSequence(const vector<string> & directories, float frameRate, Sequence & seq){
+
+	vector<vector<string>> fileNames(directories.size());
+	size_t num = 0;
+	for(size_t i = 0; i < directories.size(); i++){
+		fileNames[i] = ofxImageSequenceVideo::getImagesAtDirectory(directories[i], useDXTCompression);
+		if(fileNames[i].empty() && directories.size() > 1){
+			ofLogWarning("ofxImageSequenceVideo") << "no image files in \"" << directories[i] << "\", skipping it";
+		}
+		num += fileNames[i].size();
+	}
+
+	if(num < 2){
+		ofLogError("ofxImageSequenceVideo") << "can't open image sequence! Not enough image files in \"" << (directories.size() ? directories[0] : "") << "\"" <<
+			(directories.size() > 1 ? " and the other " + ofToString(directories.size() - 1) + " directories" : "");
+		return false;
+	}
+	if(num > std::numeric_limits<int>::max()){
+		ofLogError("ofxImageSequenceVideo") << "can't open image sequence! Too many frames (" << num << ")";
+		return false;
+	}
+
+	seq.table = std::make_shared<FrameTable>();
+	seq.table->setup(num);
+	seq.packed.reset();
+	seq.pattern.reset();
+	seq.path = directories[0];
+	seq.frameRate = frameRate;
+	for(size_t i = 0; i < directories.size(); i++){
+		if(fileNames[i].empty()) continue;
+		if(seq.table->fileExtension.empty()){
+			seq.table->fileExtension = ofFilePath::getFileExt(fileNames[i][0]);
 		}
-		closedir(dir2);
+		seq.table->addPaths(directories[i], fileNames[i]);
 	}
-	std::sort(fileNames.begin(), fileNames.end());
-	return fileNames;
+	auto & ext = seq.table->fileExtension;
+	std::transform(ext.begin(), ext.end(), ext.begin(), ofxImageSequenceVideo::asciitolower); //convert to lowercase
+	return true;
 }
 
 
-bool ofxImageSequenceVideo::loadImageSequence(const string & path, float frameRate){
+vector<string> ofxImageSequenceVideo::getSubdirectories(const string & path, bool recursive){
+	vector<string> dirs;
+	string fullPath = ofToDataPath(path, true);
+	for(auto & name : ofxImageSequenceVideoDirectory::listSubdirectories(fullPath)){
+		string dir = path + "/" + name;
+		dirs.emplace_back(dir);
+		if(recursive){
+			auto subDirs = getSubdirectories(dir, true);
+			dirs.insert(dirs.end(), subDirs.begin(), subDirs.end());
+		}
+	}
+	return dirs;
+}
 
 
-	vector<string> fileNames = ofxImageSequenceVideo::getImagesAtDirectory(path, useDXTCompression);
+bool ofxImageSequenceVideo::openSequence(const string & pattern, int firstFrame, int lastFrame, float frameRate, Sequence & seq){
+
+	if(!isValidFramePattern(pattern)){
+		ofLogError("ofxImageSequenceVideo") << "can't open image sequence! \"" << pattern << "\" is not a valid pattern, it needs a single integer field like %06d";
+		return false;
+	}
+	int num = lastFrame - firstFrame + 1;
+	if(num < 2){
+		ofLogError("ofxImageSequenceVideo") << "can't open image sequence! Not enough frames in \"" << pattern << "\" [" << firstFrame << ".." << lastFrame << "]";
+		return false;
+	}
+
+	seq.table = std::make_shared<FrameTable>();
+	seq.table->setup(num);
+	auto p = std::make_shared<FramePattern>();
+	p->pattern = ofToDataPath(pattern, true);
+	p->firstFrame = firstFrame;
+	seq.pattern = p;
+	seq.packed.reset();
+	seq.path = pattern;
+	seq.frameRate = frameRate;
+	auto & ext = seq.table->fileExtension;
+	ext = ofFilePath::getFileExt(pattern);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ofxImageSequenceVideo::asciitolower); //convert to lowercase
+	return true;
+}
 
-	ofLogVerbose("ofxImageSequenceVideo") << "loadImageSequence() \"" << path << "\"";
 
-	int num = fileNames.size();
-	if(num >= 2){
-		loaded = true;
-		imgSequencePath = path;
-		numFrames = num;
-		frameDuration = 1.0 / frameRate;
+void ofxImageSequenceVideo::setupFrames(Sequence & seq, bool gapless){
+
+	loaded = true;
+	imgSequencePath = seq.path;
+	numFrames = seq.table->numFrames;
+	frameDuration = 1.0 / seq.frameRate;
+	reversing = false;
+	newData = false;
+	if(!gapless){
 		currentFrame = 0;
 		frameOnScreenTime = -1; //force a data load!
-		newData = false;
+		transitionPending = false;
 		if(shouldLoadTexture){
 			tex.clear();
 		}
+	} //else the caller places the playhead, and the last frame stays in tex until the new one is uploaded
 
-		//move to the next data struct
-		currentFrameSet++;
-		if(currentFrameSet >= maxFramePingPongDataStructs ) currentFrameSet = 0;
+	//new table for the new sequence. Tasks still running for the old one keep it alive until they are done
+	if(frameTable){
+		eraseAllTextureCache(); //GL resources can't wait for the old table to go, that might happen on a worker thread
+	}
+	if(seq.table->generation == 0){ //a queued sequence already has its generation
+		seq.table->generation = ++lastGeneration;
+	}
+	frameTable = seq.table;
+	generation = frameTable->generation; //from now on, tasks for the old table are stale
+	packedFile = seq.packed;
+	framePattern = seq.pattern;
+	fileExtension = frameTable->fileExtension;
+	pixelPool.clear(); //new sequence might have a different frame size
+	pixelPoolPrefilled = false;
+	decodedFrameBytes = 0;
+	textureBytes = 0;
+	residentTextures.clear();
+	readaheadWindowStamps.clear(); //will be re-sized for the new sequence
+	lastDisplayedFrame = -1;
+	numMissingFrames = 0;
+	//hit rates are per sequence, as the memory use they go with
+	encodedCacheHits = 0;
+	encodedCacheMisses = 0;
+	pageCacheHits = 0;
+	pageCacheProbes = 0;
+}
+
+
+void ofxImageSequenceVideo::startLoading(){
+	if(numThreads > 0){
+		updateBufferWindow();
+		handleThreadSpawn();
+	}
+}
+
+
+bool ofxImageSequenceVideo::queueNextSequence(const string & path, float frameRate){
+	if(!loaded) return loadImageSequence(path, frameRate);
+	auto seq = std::make_unique<Sequence>();
+	if(!openSequence(path, frameRate, *seq)) return false;
+	playlist.clear(); //queued by hand, not following a playlist anymore
+	setQueuedSequence(std::move(seq));
+	return true;
+}
+
+
+bool ofxImageSequenceVideo::queueNextSequence(const vector<string> & directories, float frameRate){
+	if(!loaded) return loadImageSequence(directories, frameRate);
+	auto seq = std::make_unique<Sequence>();
+	if(!openSequence(directories, frameRate, *seq)) return false;
+	playlist.clear();
+	setQueuedSequence(std::move(seq));
+	return true;
+}
 
-		CURRENT_FRAME_ALT.clear();
-		CURRENT_FRAME_ALT.resize(num);
-		for(int i = 0; i < num; i++){
-			//CURRENT_FRAME_ALT[i].filePath = dir.getPath(i);
-			CURRENT_FRAME_ALT[i].filePath = path + "/" + fileNames[i];
-			//ofLogNotice("ofxImageSequenceVideo") << CURRENT_FRAME_ALT[i].filePath;
+
+bool ofxImageSequenceVideo::queueNextSequence(const string & pattern, int firstFrame, int lastFrame, float frameRate){
+	if(!loaded) return loadImageSequence(pattern, firstFrame, lastFrame, frameRate);
+	auto seq = std::make_unique<Sequence>();
+	if(!openSequence(pattern, firstFrame, lastFrame, frameRate, *seq)) return false;
+	playlist.clear();
+	setQueuedSequence(std::move(seq));
+	return true;
+}
+
+
+void ofxImageSequenceVideo::setQueuedSequence(std::unique_ptr<Sequence> seq){
+	clearQueuedSequence();
+	seq->table->generation = ++lastGeneration;
+	prerollGeneration = seq->table->generation; //its tasks are live from now on
+	nextSequence = std::move(seq);
+	if(numThreads > 0) updateBufferWindow(); //the current sequence's buffer stops at its end now
+}
+
+
+void ofxImageSequenceVideo::clearQueuedSequence(){
+	if(!nextSequence) return;
+	//prerolled frames go with the table, once the tasks still working on it are done; their results will be dropped
+	prerollGeneration = 0;
+	nextSequence.reset();
+	if(loaded && numThreads > 0) updateBufferWindow(); //the buffer wraps / clamps at the end again
+}
+
+
+bool ofxImageSequenceVideo::setPlaylist(const vector<string> & paths, float frameRate, bool loop){
+	if(paths.empty() || !loadImageSequence(paths[0], frameRate)){
+		return false;
+	}
+	playlist = paths;
+	playlistIndex = 0;
+	loopPlaylist = loop;
+	playlistFrameRate = frameRate;
+	queueNextPlaylistItem();
+	return true;
+}
+
+
+void ofxImageSequenceVideo::queueNextPlaylistItem(){
+	playlistNeedsQueue = false;
+	//skip items that can't be opened, but don't go around more than once
+	for(size_t i = 1; i <= playlist.size(); i++){
+		int next = playlistIndex + i;
+		if(next >= (int)playlist.size()){
+			if(!loopPlaylist) return;
+			next %= playlist.size();
 		}
-		if(numThreads > 0){
-			handleThreadSpawn();
+		auto seq = std::make_unique<Sequence>();
+		if(openSequence(playlist[next], playlistFrameRate, *seq)){
+			setQueuedSequence(std::move(seq));
+			return;
 		}
-		fileExtension = ofFilePath::getFileExt(CURRENT_FRAME_ALT[0].filePath);
-		std::transform(fileExtension.begin(), fileExtension.end(), fileExtension.begin(), ofxImageSequenceVideo::asciitolower); //convert to lowercase
-		return true;
-	}else{
-		loaded = false;
-		ofLogError("ofxImageSequenceVideo") << "can't loadImageSequence()! Not enough image files in \"" << path << "\"";
-		return false;
 	}
 }
 
+
+bool ofxImageSequenceVideo::isAtSequenceEnd(int frame, int direction){
+	if(!nextSequence || (frame >= 0 && frame < numFrames)) return false;
+	if(!reverse) return true;
+	//bouncing: the sequence ends once it's gone there and back, ie when it runs out moving against the playback speed
+	int speedDirection = playbackSpeed < 0.0f ? -1 : 1;
+	return direction != speedDirection;
+}
+
+
+void ofxImageSequenceVideo::switchToNextSequence(bool triggerEvents){
+
+	std::unique_ptr<Sequence> next = std::move(nextSequence);
+	prerollGeneration = 0;
+	float timeIntoFrame = frameOnScreenTime;
+	int shownFrame = ofClamp(currentFrame - getPlaybackDirection(), 0, numFrames - 1);
+	if(shouldLoadTexture && shouldKeepTextures() && frameTable->texState[shownFrame] == TextureState::LOADED){
+		tex = frameTable->data[shownFrame]->texture; //shares the GL texture; stays on screen until the new frame is uploaded
+	}
+	setupFrames(*next, true);
+	//the new sequence starts from the end playback comes in from
+	currentFrame = playbackSpeed < 0.0f ? numFrames - 1 : 0;
+	frameOnScreenTime = timeIntoFrame;
+	for(int i = 0; i < numFrames; i++){ //missing frames found while prerolling
+		if(frameTable->hasFlag(i, FrameTable::MISSING)) numMissingFrames++;
+	}
+	numTransitions++;
+	if(numThreads > 0){
+		transitionPending = true;
+		transitionWaitTime = 0.0f;
+		updateBufferWindow();
+	}
+	if(playlist.size()){
+		playlistIndex = (playlistIndex + 1) % playlist.size();
+		playlistNeedsQueue = true;
+	}
+
+	if(triggerEvents){
+		EventInfo info;
+		info.who = this;
+		ofNotifyEvent(eventSequenceChanged, info, this);
+	}
+}
+
+
+void ofxImageSequenceVideo::getPrerollFrames(vector<int> & frames){
+	frames.clear();
+	if(!nextSequence) return;
+	int n = nextSequence->table->numFrames;
+	//by default, the buffer window carries on into the queued sequence once the current one's end is in it
+	int num = numPrerollFrames > 0 ? numPrerollFrames : getBufferLength() - (int)bufferWindow.size();
+	num = ofClamp(num, 0, n);
+	//see switchToNextSequence(), it starts at one of the ends and plays towards the other one
+	bool backwards = playbackSpeed < 0.0f;
+	for(int i = 0; i < num; i++){
+		frames.push_back(backwards ? n - 1 - i : i);
+	}
+}
+
+
+int ofxImageSequenceVideo::getNumPrerolledFrames(){
+	if(!nextSequence) return 0;
+	vector<int> frames;
+	getPrerollFrames(frames);
+	FrameTable & table = *nextSequence->table;
+	int num = 0;
+	for(int frame : frames){
+		if(table.pixState[frame].load(std::memory_order_relaxed) == PixelState::THREAD_FINISHED_LOADING ||
+		   table.hasFlag(frame, FrameTable::MISSING)){
+			num++;
+		}
+	}
+	return num;
+}
+
+
+void ofxImageSequenceVideo::handlePrerollResults(LoadResults & results){
+	//same as handleThreadCleanup() does for the current sequence; preroll frames stay until the switch
+	FrameTable & table = *nextSequence->table;
+	int frame = results.frame;
+	PixelState state = table.pixState[frame].load(std::memory_order_acquire);
+	bool owned = results.shouldBeDisregaded || state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::FAILED;
+	if(owned && table.data[frame]->encodedBytes.size() > 0){
+		table.setFlag(frame, FrameTable::ENCODED, true);
+	}
+	if(results.shouldBeDisregaded){
+		releasePixels(table, frame);
+	}else if(!results.loadOK && owned){
+		releasePixels(table, frame);
+		table.setFlag(frame, FrameTable::MISSING, true);
+		ofLogWarning("ofxImageSequenceVideo") << "frame " << frame << " of the queued sequence is missing or can't be loaded \"" << getFramePath(nextSequence->pattern.get(), table, frame) << "\"";
+	}
+}
+
+
+void ofxImageSequenceVideo::FrameTable::setup(int num){
+	numFrames = num;
+	pixState = std::make_unique<std::atomic<PixelState>[]>(num);
+	for(int i = 0; i < num; i++){
+		pixState[i].store(PixelState::NOT_LOADED, std::memory_order_relaxed);
+	}
+	texState.assign(num, TextureState::NOT_LOADED);
+	flags.assign(num, 0);
+	data.assign(num, nullptr);
+}
+
+
+void ofxImageSequenceVideo::FrameTable::addPaths(const string & dir, const vector<string> & fileNames){
+	int firstFrame = nameOffsets.size() ? nameOffsets.size() - 1 : 0;
+	pathPrefixes.emplace_back(dir + "/");
+	prefixFirstFrames.push_back(firstFrame);
+	if(nameOffsets.empty()){ //1st chunk, size things for the whole timeline (exact for single directory sequences)
+		size_t numChars = 0;
+		for(auto & n : fileNames) numChars += n.size();
+		names.reserve(fileNames.size() ? numChars * numFrames / fileNames.size() : 0);
+		nameOffsets.reserve(numFrames + 1);
+		nameOffsets.push_back(0);
+	}
+	for(auto & n : fileNames){
+		names += n;
+		nameOffsets.push_back(names.size());
+	}
+}
+
+
+ofxImageSequenceVideo::FrameData & ofxImageSequenceVideo::FrameTable::acquireData(int frame){
+	if(!data[frame]){
+		if(freeData.size()){
+			data[frame] = freeData.back();
+			freeData.pop_back();
+		}else{
+			dataSlots.emplace_back(std::make_unique<FrameData>());
+			data[frame] = dataSlots.back().get();
+		}
+	}
+	return *data[frame];
+}
+
+
+void ofxImageSequenceVideo::FrameTable::releaseData(int frame){
+	FrameData * d = data[frame];
+	if(!d) return;
+	if(pixState[frame].load(std::memory_order_relaxed) != PixelState::NOT_LOADED) return; //pixels in use
+	if(texState[frame] == TextureState::LOADED || d->encodedBytes.size() > 0) return;
+	data[frame] = nullptr;
+	freeData.push_back(d);
+}
+
+
+bool ofxImageSequenceVideo::isValidFramePattern(const string & pattern){
+	int numFields = 0;
+	for(size_t i = 0; i < pattern.size(); i++){
+		if(pattern[i] != '%') continue;
+		i++;
+		if(i < pattern.size() && pattern[i] == '%') continue; //literal %
+		while(i < pattern.size() && (pattern[i] == '0' || pattern[i] == '-' || pattern[i] == '+' || pattern[i] == ' ')) i++; //flags
+		size_t widthStart = i;
+		while(i < pattern.size() && isdigit((unsigned char)pattern[i])) i++;
+		if(i - widthStart > 3) return false; //that's a silly width
+		if(i < pattern.size() && pattern[i] == '.'){ //precision, also zero pads integers (ie %.6d)
+			i++;
+			size_t precisionStart = i;
+			while(i < pattern.size() && isdigit((unsigned char)pattern[i])) i++;
+			if(i - precisionStart > 3) return false;
+		}
+		if(i >= pattern.size()) return false;
+		char conversion = pattern[i];
+		if(conversion != 'd' && conversion != 'i' && conversion != 'u') return false;
+		numFields++;
+	}
+	return numFields == 1;
+}
+
+
+const string & ofxImageSequenceVideo::getFramePath(const FramePattern * pattern, const FrameTable & table, int frameIndex){
+	thread_local string path; //keeps its capacity, so no allocations after the 1st frame
+	if(!pattern){
+		if((size_t)frameIndex + 1 >= table.nameOffsets.size()){ //.isv, frames have no paths
+			path.clear();
+		}else{
+			uint32_t start = table.nameOffsets[frameIndex];
+			size_t chunk = 0;
+			if(table.prefixFirstFrames.size() > 1){ //which chunk the frame is in
+				auto it = std::upper_bound(table.prefixFirstFrames.begin(), table.prefixFirstFrames.end(), frameIndex);
+				chunk = (it - table.prefixFirstFrames.begin()) - 1;
+			}
+			path.assign(table.pathPrefixes[chunk]);
+			path.append(table.names, start, table.nameOffsets[frameIndex + 1] - start);
+		}
+		return path;
+	}
+	int value = pattern->firstFrame + frameIndex;
+	if(path.size() < pattern->pattern.size() + 16) path.resize(pattern->pattern.size() + 16);
+	while(true){
+		int len = snprintf(&path[0], path.size() + 1, pattern->pattern.c_str(), value); //the pattern is validated on load
+		if(len < 0){
+			path.clear();
+			break;
+		}
+		if((size_t)len <= path.size()){
+			path.resize(len);
+			break;
+		}
+		path.resize(len);
+	}
+	return path;
+}
+
 float ofxImageSequenceVideo::getMovieDuration(){
 
 	float ret = 0;
@@ -169,35 +715,53 @@ float ofxImageSequenceVideo::getMovieDuration(){
 
 size_t ofxImageSequenceVideo::getEstimatdVramUse(){
 
-	if(currentFrameSet < 0){
+	if(!frameTable){
 		ofLogError("ofxImageSequenceVideo") << "can't getEstimatdVramUse() because no image sequence was loaded!";
 		return 0;
 	}
 
-	if(frames[currentFrameSet].size()){
+	if(frameTable->numFrames){
 
-		if(CURRENT_FRAME_ALT[0].pixState == PixelState::LOADED){
-			auto & pix = CURRENT_FRAME_ALT[0].pixels;
+		if(frameTable->pixState[0] == PixelState::LOADED && frameTable->data[0] && frameTable->data[0]->pixels.isAllocated()){
+			auto & pix = frameTable->data[0]->pixels;
 			return pix.getWidth() * pix.getHeight() * pix.getNumPlanes() * (size_t)numFrames;
 		}
-		if(CURRENT_FRAME_ALT[0].texState == TextureState::LOADED){
-			auto & tex = CURRENT_FRAME_ALT[0].texture;
+		if(frameTable->texState[0] == TextureState::LOADED){
+			auto & tex = frameTable->data[0]->texture;
 			size_t numChannels = ofGetNumChannelsFromGLFormat(tex.getTextureData().glInternalFormat);
 			return tex.getWidth() * tex.getHeight() * numChannels * (size_t)numFrames;
 		}
-		if(!useDXTCompression){
+		if(packedFile && useDXTCompression){ //the blocks are uploaded as they are
+			return (size_t)numFrames * packedFile->getEntry(0).size;
+		}
+		if(packedFile && packedFile->getEntry(0).width > 0){
+			auto & e = packedFile->getEntry(0);
+			int f = ofxImageSequenceVideoScale::getFactor(e.width, e.height, targetWidth, targetHeight);
+			return (size_t)numFrames * ofxImageSequenceVideoScale::getScaledSize(e.width, f) * ofxImageSequenceVideoScale::getScaledSize(e.height, f) * (size_t)e.numChannels;
+		}
+		if(!useDXTCompression && !packedFile){
 			int w, h, nChannels;
 			bool ok;
-			ofxImageSequenceVideo::getImageInfo(CURRENT_FRAME_ALT[0].filePath, w, h, nChannels, ok);
+			ofxImageSequenceVideo::getImageInfo(getFramePath(framePattern.get(), *frameTable, 0), w, h, nChannels, ok);
 			if(ok){
-				return (size_t)numFrames * (size_t)w * (size_t)h * (size_t)nChannels;
+				int f = ofxImageSequenceVideoScale::getFactor(w, h, targetWidth, targetHeight);
+				return (size_t)numFrames * ofxImageSequenceVideoScale::getScaledSize(w, f) * ofxImageSequenceVideoScale::getScaledSize(h, f) * (size_t)nChannels;
 			}else{
-				ofLogError("ofxImageSequenceVideo") << "Can't getEstimatdVramUse(). cant load image! " << CURRENT_FRAME_ALT[0].filePath;
+				ofLogError("ofxImageSequenceVideo") << "Can't getEstimatdVramUse(). cant load image! " << getFramePath(framePattern.get(), *frameTable, 0);
 				return 0;
 			}
+		}else if(packedFile){
+			ofPixels pix;
+			ofxDXT::Data data;
+			ofxImageSequenceVideoDXTView view;
+			if(loadFrameData(packedFile.get(), 0, "", fileExtension, pix, data, view)){
+				return pix.getWidth() * pix.getHeight() * pix.getNumPlanes() * (size_t)numFrames;
+			}
+			ofLogError("ofxImageSequenceVideo") << "Can't getEstimatdVramUse(). cant load image from " << packedFile->getPath();
+			return 0;
 		}else{
 			ofxDXT::Data data;
-			bool ok = ofxDXT::loadFromDisk(CURRENT_FRAME_ALT[0].filePath, data);
+			bool ok = ofxDXT::loadFromDisk(getFramePath(framePattern.get(), *frameTable, 0), data);
 			if(ok){
 				size_t bytes;
 				if (data.getCompressionType() == ofxDXT::DXT1){
@@ -210,7 +774,7 @@ size_t ofxImageSequenceVideo::getEstimatdVramUse(){
 
 				return bytes;
 			}
-			ofLogError("ofxImageSequenceVideo") << "Can't getEstimatdVramUse(). cant load DXT image! " << CURRENT_FRAME_ALT[0].filePath;
+			ofLogError("ofxImageSequenceVideo") << "Can't getEstimatdVramUse(). cant load DXT image! " << getFramePath(framePattern.get(), *frameTable, 0);
 			return 0;
 		}
 	}else{
@@ -219,361 +783,1167 @@ size_t ofxImageSequenceVideo::getEstimatdVramUse(){
 	}
 }
 
-void ofxImageSequenceVideo::setHoldPlaybackWhenFramesArentReady(bool hold){
-	playAllFrames = hold;
+void ofxImageSequenceVideo::setHoldPlaybackWhenFramesArentReady(bool hold){
+	playAllFrames = hold;
+}
+
+void ofxImageSequenceVideo::update(float dt){
+
+	if(!loaded) return;
+
+	newData = false;
+	updateDtAvg = updateDtAvg > 0.0f ? ofLerp(updateDtAvg, dt, 0.1) : dt;
+
+	if(playback){
+		frameOnScreenTime += dt * fabs(playbackSpeed); //direction is handled in advanceFrameInternal()
+	}
+
+	//calc what frame to jump to (if any)
+	int numFramesToAdvance = 0;
+	if(frameOnScreenTime < 0.0f){
+		numFramesToAdvance = 1;
+	}else{
+		if(frameOnScreenTime >= frameDuration){
+			numFramesToAdvance = int(frameOnScreenTime / frameDuration);
+			if(playAllFrames && numFramesToAdvance > 1) numFramesToAdvance = 1;
+		}
+	}
+
+	if(numThreads > 0){ //async mode - spawn threads to load frames in the future and wait for them to be done / sync
+
+		FrameTable & table = *frameTable;
+
+		bool pixelsAreReady = table.pixState[currentFrame] == PixelState::THREAD_FINISHED_LOADING;
+
+		if(transitionPending){ //just switched to a queued sequence, is its 1st frame here in time?
+			PixelState s = table.pixState[currentFrame];
+			if(pixelsAreReady || s == PixelState::LOADED || s == PixelState::FAILED || table.texState[currentFrame] == TextureState::LOADED || isFrameMissing(currentFrame)){
+				transitionPending = false;
+				if(transitionWaitTime > 0.0f){
+					numTransitionStalls++;
+					lastTransitionStallTime = transitionWaitTime;
+					ofLogWarning("ofxImageSequenceVideo") << "stalled " << ofToString(1000 * transitionWaitTime, 1) << "ms switching to \"" << imgSequencePath << "\"";
+				}
+			}else{
+				transitionWaitTime += dt;
+			}
+		}
+
+		if(pixelsAreReady){ //1st update() call in which the pixels are available - load to GPU and change state to LOADED
+
+			FrameData & curFrame = *table.data[currentFrame];
+			if(shouldLoadTexture){
+
+				if(table.texState[currentFrame] == TextureState::NOT_LOADED){
+
+					//TS_SCOPE("load 2 GPU");
+
+					if(shouldKeepTextures()){ //load into frames vector
+						//TS_START_ACC("load tex KEEP");
+						if(!useDXTCompression){
+							curFrame.texture.loadData(curFrame.pixels);
+						}else{
+							loadDXTIntoTexture(curFrame.compressedPixels, curFrame.compressedView, curFrame.texture);
+						}
+						//TS_STOP_ACC("load tex KEEP");
+						table.texState[currentFrame] = TextureState::LOADED;
+						if(textureBytes == 0){
+							textureBytes = getFrameBytes(curFrame);
+						}
+						residentTextures.insert(currentFrame);
+						trimTextureCache();
+					}else{ //load into reusable texture
+						//TS_START_ACC("load tex ONE-OFF");
+						if(!useDXTCompression){
+							tex.loadData(curFrame.pixels);
+						}else{
+							loadDXTIntoTexture(curFrame.compressedPixels, curFrame.compressedView, tex);
+						}
+						//TS_STOP_ACC("load tex ONE-OFF");
+					}
+				}
+			}
+			table.pixState[currentFrame] = PixelState::LOADED;
+			newData = true;
+		}
+
+		PixelState state = table.pixState[currentFrame];
+
+		bool pixelsReady = (state == PixelState::THREAD_FINISHED_LOADING|| state == PixelState::LOADED);
+		pixelsReady |= state == PixelState::FAILED || isFrameMissing(currentFrame); //nothing to wait for, tex keeps the last good frame
+		bool loop = (shouldLoop || (!shouldLoop && (currentFrame <= (numFrames - 1))));
+		bool isTextureReady = table.texState[currentFrame] == TextureState::LOADED;
+
+		if(playback && (numFramesToAdvance > 0) && loop && (pixelsReady || isTextureReady)){
+			for(int i = 0; i < numFramesToAdvance; i++){
+				handleScreenTimeCounters(dt);
+				advanceFrameInternal();
+				handleLooping(true);
+			}
+		}
+
+		handleLooping(true);
+		if(playlistNeedsQueue) queueNextPlaylistItem();
+		int bufferLength = getBufferLength();
+		if(bufferLength < lastBufferLength){ //less of the RAM budget left for the buffer (ie the encoded tier grew), drop what doesn't fit
+			eraseOutOfBufferPixelCache(); //updates the window too
+		}else{
+			updateBufferWindow();
+		}
+		lastBufferLength = bufferLength;
+		handleThreadCleanup();
+		handleThreadSpawn();
+		handleReadaheadHints();
+
+		//update buffer statistics - only touches the packed state arrays
+		FrameTable & current = *frameTable; //playback might have switched to a queued sequence above
+		int numLoaded = 0;
+		for(int frame : bufferWindow){
+			PixelState state = current.pixState[frame].load(std::memory_order_relaxed);
+			if(state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED || state == PixelState::FAILED ||
+			   current.texState[frame] == TextureState::LOADED || current.hasFlag(frame, FrameTable::MISSING)){
+				numLoaded++;
+			}
+		}
+		if(bufferWindow.size()){
+			bufferFullness = ofLerp(bufferFullness,(numLoaded / float(bufferWindow.size())), 0.1);
+		}
+
+	}else{ //immediate mode, we load what we need on demand on the main frame blocking
+
+		if(playback && (frameOnScreenTime >= frameDuration || frameOnScreenTime < 0.0f) &&
+		   (shouldLoop || (!shouldLoop && (currentFrame <= (numFrames - 1))))
+		   ){
+
+			int oldFrame = currentFrame;
+			uint32_t oldGeneration = frameTable->generation;
+			for(int i = 0; i < numFramesToAdvance; i++){
+				handleScreenTimeCounters(dt);
+				advanceFrameInternal();
+				handleLooping(true);
+			}
+			if(frameTable->generation != oldGeneration){ //switched to the queued sequence, oldFrame is not in this one
+				oldFrame = -1;
+			}
+			if(playlistNeedsQueue) queueNextPlaylistItem();
+
+			if(oldFrame != currentFrame){ //data is not new if we are not looping and we are stuck in the last frame
+				newData = true;
+				loadPixelsNow(currentFrame, oldFrame);
+			}
+		}
+
+		if(texNeedsLoad && shouldLoadTexture){
+			texNeedsLoad = false;
+			TS_START_ACC("load pix GPU");
+
+			if(!useDXTCompression){
+				tex.loadData(currentPixels);
+			}else{
+				loadDXTIntoTexture(currentPixelsCompressed, currentCompressedView, tex);
+			}
+			TS_STOP_ACC("load pix GPU");
+		}
+	}
+}
+
+
+void ofxImageSequenceVideo::setPlaybackFramerate(float framerate){
+	frameDuration = 1.0f / framerate;
+}
+
+void ofxImageSequenceVideo::handleLooping(bool triggerEvents){
+
+	if(isAtSequenceEnd(currentFrame, getPlaybackDirection())){ //hand over to the queued sequence instead
+		switchToNextSequence(triggerEvents);
+		return;
+	}
+
+	bool looped = false;
+	if(currentFrame >= numFrames){ //went past the end
+		if(shouldLoop){ //loop movie
+			if(reverse){ //bounce back
+				currentFrame = numFrames - 1;
+				reversing = !reversing;
+			}else{
+				currentFrame = 0;
+			}
+			looped = true;
+		}else{ //movie stops at last frame
+			currentFrame = numFrames - 1;
+		}
+	}else if(currentFrame < 0){ //went past the start - either bouncing or playing backwards
+		if(reverse){ //bounce back
+			currentFrame = 0;
+			reversing = !reversing;
+		}else if(shouldLoop){
+			currentFrame = numFrames - 1;
+			looped = true;
+		}else{ //movie stops at 1st frame
+			currentFrame = 0;
+		}
+	}
+
+	if(looped && triggerEvents){
+		EventInfo info;
+		info.who = this;
+		ofNotifyEvent(eventMovieLooped, info, this);
+	}
+}
+
+
+int ofxImageSequenceVideo::getPlaybackDirection(){
+	int direction = reversing ? -1 : 1;
+	return playbackSpeed < 0.0f ? -direction : direction;
+}
+
+
+int ofxImageSequenceVideo::stepFrame(int frame, int & direction){
+	//mirrors what advanceFrameInternal() + handleLooping() do to currentFrame
+	frame += direction;
+	if(isAtSequenceEnd(frame, direction)) return -1; //the queued sequence takes over from here
+	if(frame >= numFrames){
+		if(!shouldLoop) return numFrames - 1;
+		if(reverse){
+			direction = -direction;
+			return numFrames - 1;
+		}
+		return 0;
+	}
+	if(frame < 0){
+		if(reverse){
+			direction = -direction;
+			return 0;
+		}
+		if(!shouldLoop) return 0;
+		return numFrames - 1;
+	}
+	return frame;
+}
+
+
+void ofxImageSequenceVideo::getUpcomingFrames(int numUpcomingFrames, vector<int> & upcomingFrames, vector<float> * timesUntilShown){
+
+	upcomingFrames.clear();
+	if(timesUntilShown) timesUntilShown->clear();
+	if(numFrames <= 0) return;
+
+	int direction = getPlaybackDirection();
+	int frame = ofClamp(currentFrame, 0, numFrames - 1);
+	float speed = MAX(fabs(playbackSpeed), 0.01f);
+	float timeOnScreen = MAX(frameOnScreenTime, 0.0f);
+
+	//how many frames each update() call will advance - see update()
+	float framesPerUpdate = 1.0f;
+	if(playback && !playAllFrames && updateDtAvg > 0.0f){
+		framesPerUpdate = updateDtAvg * speed / frameDuration;
+	}
+
+	if(framesPerUpdate <= 1.0f){ //every frame will be presented
+		for(int i = 0; i < numUpcomingFrames; i++){
+			upcomingFrames.push_back(frame);
+			if(timesUntilShown) timesUntilShown->push_back((i * frameDuration - timeOnScreen) / speed);
+			frame = stepFrame(frame, direction);
+			if(frame < 0) break; //the rest belongs to the queued sequence
+		}
+	}else{ //update() skips frames; only list the ones that will land on screen
+		float framesInto = timeOnScreen / frameDuration; //progress into the current frame, in frames
+		float time = 0.0f;
+		upcomingFrames.push_back(frame);
+		if(timesUntilShown) timesUntilShown->push_back(0.0f);
+		while((int)upcomingFrames.size() < numUpcomingFrames){
+			framesInto += framesPerUpdate;
+			time += updateDtAvg;
+			int numToAdvance = (int)framesInto;
+			framesInto -= numToAdvance;
+			for(int i = 0; i < numToAdvance && frame >= 0; i++){
+				frame = stepFrame(frame, direction);
+			}
+			if(frame < 0) break;
+			upcomingFrames.push_back(frame);
+			if(timesUntilShown) timesUntilShown->push_back(time);
+		}
+	}
+}
+
+
+void ofxImageSequenceVideo::updateBufferWindow(){
+
+	if(bufferWindowStamps.size() != (size_t)numFrames){
+		bufferWindowStamps.assign(numFrames, 0);
+		bufferWindowStamp = 0;
+	}
+	bufferWindowStamp++;
+	if(bufferWindowStamp == 0){ //wrapped around, reset all stamps
+		std::fill(bufferWindowStamps.begin(), bufferWindowStamps.end(), 0);
+		bufferWindowStamp = 1;
+	}
+	int bufferLength = MIN(getBufferLength(), numFrames);
+	int numUpcoming = bufferLength;
+	if(readaheadDistance > 0 && numThreads > 0){ //the frames past the buffer window are simulated in the same pass
+		numUpcoming = MIN(bufferLength + readaheadDistance, numFrames);
+		if(readaheadWindowStamps.size() != (size_t)numFrames){
+			readaheadWindowStamps.assign(numFrames, 0);
+		}
+	}
+	getUpcomingFrames(numUpcoming, bufferWindow, &bufferWindowTimes);
+	readaheadWindow.clear();
+	if((int)bufferWindow.size() > bufferLength){ //might be short, if the queued sequence takes over before
+		readaheadWindow.assign(bufferWindow.begin() + bufferLength, bufferWindow.end());
+		bufferWindow.resize(bufferLength);
+		bufferWindowTimes.resize(bufferLength);
+		if(bufferWindowStamp == 1) std::fill(readaheadWindowStamps.begin(), readaheadWindowStamps.end(), 0); //stamps wrapped
+		for(int frame : readaheadWindow){
+			readaheadWindowStamps[frame] = bufferWindowStamp;
+		}
+	}
+	for(int frame : bufferWindow){
+		bufferWindowStamps[frame] = bufferWindowStamp;
+	}
+}
+
+
+void ofxImageSequenceVideo::handleReadaheadHints(){
+
+	if(readaheadDistance <= 0 || readaheadWindowStamps.size() != (size_t)numFrames) return;
+
+	vector<string> willNeedFiles;
+	vector<string> dontNeedFiles;
+	auto packed = packedFile;
+	FrameTable & table = *frameTable;
+
+	//frames coming up after the buffer window
+	for(int frame : readaheadWindow){
+		if(table.hasFlag(frame, FrameTable::PAGE_CACHE_HINTED | FrameTable::ENCODED)) continue; //encoded RAM tier won't hit the disk
+		if(table.pixState[frame].load(std::memory_order_relaxed) != PixelState::NOT_LOADED) continue;
+		if(shouldKeepTextures() && table.texState[frame] == TextureState::LOADED) continue; //won't be read again
+		table.setFlag(frame, FrameTable::PAGE_CACHE_HINTED, true);
+		if(packed){
+			packed->willNeed(frame); //non blocking
+		}else{
+			willNeedFiles.emplace_back(ofToDataPath(getFramePath(framePattern.get(), table, frame), true));
+		}
+	}
+
+	//the frame we just moved away from - drop it unless it's coming back soon (short loops, bouncing)
+	if(dropDisplayedFrames && lastDisplayedFrame >= 0 && lastDisplayedFrame < numFrames && lastDisplayedFrame != currentFrame){
+		int frame = lastDisplayedFrame;
+		bool comingBack = isFrameInBuffer(frame) || readaheadWindowStamps[frame] == bufferWindowStamp;
+		if(!comingBack && !table.hasFlag(frame, FrameTable::ENCODED)){
+			table.setFlag(frame, FrameTable::PAGE_CACHE_HINTED, false);
+			if(packed){
+				packed->dontNeed(frame);
+			}else{
+				dontNeedFiles.emplace_back(ofToDataPath(getFramePath(framePattern.get(), table, frame), true));
+			}
+		}
+	}
+	lastDisplayedFrame = currentFrame;
+
+	if(willNeedFiles.empty() && dontNeedFiles.empty()) return;
+	//opening files can block (network mounts!), so hints go through the pool, behind the frames we are loading
+	auto pool = ioPool ? ioPool : threadPool;
+	int clientID = ioPool ? ioPoolClientID : threadPoolClientID;
+	double deadline = bufferWindowTimes.size() ? bufferWindowTimes.back() : 0.0;
+	if(!playback) deadline += 1.0;
+	pool->submit(clientID, deadline, [willNeedFiles, dontNeedFiles](){
+		for(auto & path : willNeedFiles) ofxImageSequenceVideoPageCache::willNeed(path);
+		for(auto & path : dontNeedFiles) ofxImageSequenceVideoPageCache::dontNeed(path);
+	});
+}
+
+
+void ofxImageSequenceVideo::setReadaheadHints(int distance, bool dropDisplayedFrames){
+	readaheadDistance = MAX(0, distance);
+	this->dropDisplayedFrames = dropDisplayedFrames;
+	if(loaded) updateBufferWindow();
+}
+
+
+float ofxImageSequenceVideo::getPageCacheHitRate(){
+	return pageCacheProbes ? pageCacheHits / float(pageCacheProbes) : 0.0f;
+}
+
+
+void ofxImageSequenceVideo::handleThreadCleanup(){
+	//gather the results of all finished tasks - cost is proportional to the work actually done since last update
+	LoadResults results;
+	FrameTable & table = *frameTable;
+	while(completedTasks.pop(results)){
+		numTasksInFlight--;
+		if(results.generation != table.generation){ //for a sequence that's been replaced, its frame table is gone (or going)
+			if(nextSequence && results.generation == nextSequence->table->generation){
+				handlePrerollResults(results);
+			}
+			continue;
+		}
+		if(results.pageCacheHit >= 0){
+			pageCacheProbes++;
+			pageCacheHits += results.pageCacheHit;
+			table.setFlag(results.frame, FrameTable::PAGE_CACHE_HINTED, false); //read, hint again next time around
+		}
+		loadTimeAvg = ofLerp(loadTimeAvg, results.elapsedTime, 0.1);
+		readTimeAvg = ofLerp(readTimeAvg, results.readTime, 0.1);
+		decodeTimeAvg = ofLerp(decodeTimeAvg, results.decodeTime, 0.1);
+		if(ioPool || uringReader){
+			queueWaitAvg = ofLerp(queueWaitAvg, results.queueWaitTime, 0.1);
+		}
+		if(reportFileSize){
+			if (fileSizeAvgKb <= 0.0f){
+				fileSizeAvgKb = results.filesizeKb;
+			}else{
+				fileSizeAvgKb = ofLerp(fileSizeAvgKb, results.filesizeKb, 0.1);
+			}
+		}
+		//the queue hand-off orders the worker's writes before this point, so pixel data is safe to touch here
+		int frame = results.frame;
+		PixelState state = table.pixState[frame].load(std::memory_order_acquire);
+		bool owned = results.shouldBeDisregaded || state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED ||
+					 state == PixelState::FAILED;
+		//(if the frame was already consumed and is being loaded again, it's not ours to touch)
+		if(owned && table.data[frame]->encodedBytes.size() > 0){
+			table.setFlag(frame, FrameTable::ENCODED, true);
+		}
+		if(results.shouldBeDisregaded){ //state is DISREGARDED, nobody else touches the frame until we reset it
+			releasePixels(frame);
+			//ofLogWarning("ofxImageSequenceVideo") << "thread cleanup frame " << results.frame;
+		}else if(!results.loadOK && owned){
+			releasePixels(frame);
+			handleMissingFrame(frame);
+		}else if(owned){
+			FrameData & curFrame = *table.data[frame];
+			if(!pixelPoolPrefilled && curFrame.pixels.isAllocated()){ //now we know the frame size, allocate all buffers upfront
+				pixelPool.prefill(curFrame.pixels);
+				pixelPoolPrefilled = true;
+			}
+			if(decodedFrameBytes == 0){ //now we know how many frames fit in the RAM budget
+				decodedFrameBytes = getFrameBytes(curFrame);
+			}
+			if(!isFrameInBuffer(frame)){ //test if the loading finished too late
+				releasePixels(frame);
+			}
+		}
+		//ofLogNotice("ofxImageSequenceVideo") << ofGetFrameNum() << " - frame loaded! " << frame;
+	}
+}
+
+
+void ofxImageSequenceVideo::handleMissingFrame(int frame){
+	//not retried; playback goes on, holding the last frame that could be shown
+	frameTable->setFlag(frame, FrameTable::MISSING, true);
+	numMissingFrames++;
+	ofLogWarning("ofxImageSequenceVideo") << "frame " << frame << " is missing or can't be loaded \"" << getFramePath(framePattern.get(), *frameTable, frame) << "\"";
+}
+
+
+void ofxImageSequenceVideo::handleScreenTimeCounters(float dt){
+	if(frameOnScreenTime >= 0.0f){
+		frameOnScreenTime -= frameDuration;
+	}else{
+		frameOnScreenTime = dt;
+	}
+}
+
+void ofxImageSequenceVideo::handleThreadSpawn(){
+
+	int maxTasksInFlight = numThreads;
+	if(ioPool) maxTasksInFlight += numIoThreads + maxQueuedDecodes; //enough to keep both stages busy
+	if(uringReader) maxTasksInFlight += maxQueuedDecodes; //reads in flight + read frames waiting for a decode thread
+	int numToSpawn = maxTasksInFlight - numTasksInFlight;
+
+	if(bufferFullness > 0.75 && getBufferLength() < numFrames){ //dont overspawn if we have enough data already - unless we are trying to load the whole sequence
+		numToSpawn = ofClamp(numToSpawn, 0, 1);
+	}
+
+	int direction = getPlaybackDirection();
+	std::vector<std::unique_ptr<ofxImageSequenceVideoUringReader::Request>> uringRequests;
+	FrameTable & table = *frameTable;
+	Sequence current; //tasks keep the table, packed file & pattern alive while they run
+	current.table = frameTable;
+	current.packed = packedFile;
+	current.pattern = framePattern;
+
+	//walk the buffer window in playback order, looking for frames that need loading
+	for(size_t i = 0; i < bufferWindow.size() && numToSpawn > 0; i++){
+		int frameToLoad = bufferWindow[i];
+		if(table.pixState[frameToLoad].load(std::memory_order_relaxed) != PixelState::NOT_LOADED) continue;
+		if(table.hasFlag(frameToLoad, FrameTable::MISSING)) continue;
+		//if keeping textures in mem, dont spawn thread to load pixels if textures are already there
+		if(shouldKeepTextures() && table.texState[frameToLoad] == TextureState::LOADED) continue;
+
+		//ofLogNotice("ofxImageSequenceVideo") << ofGetFrameNum() << " - spawn thread to load frame " << frameToLoad;
+		//deadline: how long until this frame is due on screen
+		double deadline = bufferWindowTimes[i];
+		if(!playback) deadline += 1.0; //paused players are less urgent
+		numToSpawn--;
+		if(packedFile && readaheadDistance == 0){ //start paging in the frame that will be loaded one buffer length from now
+			packedFile->willNeed(((frameToLoad + direction * getBufferLength()) % numFrames + numFrames) % numFrames);
+		}
+		spawnLoad(current, frameToLoad, deadline, uringRequests);
+	}
+
+	//spare slots preroll the start of the queued sequence, due right after the current one runs out
+	if(nextSequence && numToSpawn > 0){
+		FrameTable & next = *nextSequence->table;
+		float speed = MAX(fabs(playbackSpeed), 0.01f);
+		double switchTime = bufferWindowTimes.size() ? bufferWindowTimes.back() + frameDuration / speed : 0.0;
+		vector<int> prerollFrames;
+		getPrerollFrames(prerollFrames);
+		for(size_t i = 0; i < prerollFrames.size() && numToSpawn > 0; i++){
+			int frameToLoad = prerollFrames[i];
+			if(next.pixState[frameToLoad].load(std::memory_order_relaxed) != PixelState::NOT_LOADED) continue;
+			if(next.hasFlag(frameToLoad, FrameTable::MISSING)) continue;
+			double deadline = switchTime + i / (nextSequence->frameRate * speed);
+			if(!playback) deadline += 1.0;
+			numToSpawn--;
+			spawnLoad(*nextSequence, frameToLoad, deadline, uringRequests);
+		}
+	}
+
+	if(uringRequests.size()){
+		uringReader->read(uringRequests); //all reads spawned this update go out as one batch
+	}
+}
+
+
+void ofxImageSequenceVideo::spawnLoad(const Sequence & seq, int frame, double deadline,
+									  std::vector<std::unique_ptr<ofxImageSequenceVideoUringReader::Request>> & uringRequests){
+
+	seq.table->acquireData(frame); //the worker gets the frame's FrameData
+	seq.table->pixState[frame].store(PixelState::LOADING, std::memory_order_relaxed); //the pool's queue lock publishes this to the worker
+	numTasksInFlight++;
+	if(uringReader){
+		submitUringLoad(seq, frame, deadline, uringRequests);
+	}else if(ioPool){
+		submitPipelinedLoad(seq, frame, deadline);
+	}else{
+		auto table = seq.table; //the task owns a reference to its table, it might outlive this sequence
+		auto packed = seq.packed;
+		auto pattern = seq.pattern;
+		threadPool->submit(threadPoolClientID, deadline, [this, table, frame, packed, pattern](){
+			completedTasks.push(loadFrameThread(*table, frame, packed.get(), pattern.get()));
+		});
+	}
+}
+
+
+ofxImageSequenceVideo::LoadResults ofxImageSequenceVideo::loadFrameThread(FrameTable & table, int frame, ofxImageSequenceVideoPackedFile * packed,
+																		   const FramePattern * pattern){
+
+	//runs on a worker thread - only touch the frame's FrameData and immutable sequence info here!
+	uint64_t t = ofGetElapsedTimeMicros();
+	LoadResults results;
+	results.frame = frame;
+	results.generation = table.generation;
+	if(isStale(table)) return results; //a new sequence was loaded while this one was queued, nobody wants it
+
+	FrameData & curFrame = *table.data[frame];
+	pixelPool.acquire(curFrame.pixels);
+	const unsigned char * buffer = curFrame.pixels.getData();
+	results.loadOK = loadFrameData(packed, frame, getFramePath(pattern, table, frame), table.fileExtension, curFrame.pixels, curFrame.compressedPixels,
+								   curFrame.compressedView, &results, &curFrame.encodedBytes, &table.encodedCacheBytes);
+
+	//ofSleepMillis(130); //testing large assets
+
+	publishFrame(table, frame, buffer, results);
+
+	//prepare report
+	t = ofGetElapsedTimeMicros() - t;
+	results.elapsedTime = t / 1000.0f;
+	return results;
+}
+
+
+void ofxImageSequenceVideo::publishFrame(FrameTable & table, int frame, const unsigned char * prevPixelBuffer, LoadResults & results){
+
+	FrameData & curFrame = *table.data[frame];
+	if(!useDXTCompression){
+		pixelPool.reportDecode(prevPixelBuffer == nullptr || prevPixelBuffer != curFrame.pixels.getData());
+	}
+	table.ramBytesInUse += getFrameBytes(curFrame);
+
+	//publish the pixels; if the main thread flagged the frame as disregarded in the meantime, the CAS fails
+	//and the main thread will free the data when it gets our results (the buffer window is checked there too).
+	//A failed load is published as FAILED, so update() never uploads whatever the (recycled) buffer holds
+	PixelState expected = PixelState::LOADING;
+	PixelState done = results.loadOK ? PixelState::THREAD_FINISHED_LOADING : PixelState::FAILED;
+	bool published = table.pixState[frame].compare_exchange_strong(expected, done, std::memory_order_release, std::memory_order_relaxed);
+	results.shouldBeDisregaded = !published;
 }
 
-void ofxImageSequenceVideo::update(float dt){
 
-	if(!loaded) return;
+void ofxImageSequenceVideo::submitPipelinedLoad(const Sequence & seq, int frameIndex, double deadline){
 
-	newData = false;
+	auto job = std::make_shared<PipelineJob>();
+	job->table = seq.table;
+	job->frameIndex = frameIndex;
+	job->results.generation = seq.table->generation;
+	job->packed = seq.packed; //keep the packed file alive while the job runs
+	job->pattern = seq.pattern;
+	job->dueTime = ofxImageSequenceVideoThreadPool::now() + deadline;
+	ioPool->submit(ioPoolClientID, deadline, [this, job](){
+		readStage(job);
+	});
+}
 
-	if(playback){
-        if(currentFrame < 0)
-        {
-            currentFrame = 0;
-            reversing = false;
-        }
-		frameOnScreenTime += dt * playbackSpeed;
-	}
 
-	//calc what frame to jump to (if any)
-	int numFramesToAdvance = 0;
-	if(frameOnScreenTime < 0.0f){
-		numFramesToAdvance = 1;
-	}else{
-		if(frameOnScreenTime >= frameDuration){
-			numFramesToAdvance = int(frameOnScreenTime / frameDuration);
-			if(playAllFrames && numFramesToAdvance > 1) numFramesToAdvance = 1;
-		}
+void ofxImageSequenceVideo::readStage(std::shared_ptr<PipelineJob> job){
+
+	//runs on an I/O thread
+	uint64_t t = ofGetElapsedTimeMicros();
+	FrameTable & table = *job->table;
+	FrameData & curFrame = *table.data[job->frameIndex];
+	LoadResults & results = job->results;
+	results.frame = job->frameIndex;
+	if(isStale(table)){ //skip the read, and the decode
+		completedTasks.push(results);
+		return;
 	}
 
-	if(numThreads > 0){ //async mode - spawn threads to load frames in the future and wait for them to be done / sync
+	const FramePattern * pattern = job->pattern.get();
 
-		FrameInfo & curFrame = CURRENT_FRAME_ALT[currentFrame];
+	if(useDXTCompression){ //nothing to decode, the whole load happens here
+		results.loadOK = loadFrameData(job->packed.get(), job->frameIndex, getFramePath(pattern, table, job->frameIndex), table.fileExtension, curFrame.pixels,
+									   curFrame.compressedPixels, curFrame.compressedView, &results);
+		publishFrame(table, job->frameIndex, nullptr, results);
+		results.readTime = results.elapsedTime = (ofGetElapsedTimeMicros() - t) / 1000.0f;
+		completedTasks.push(results);
+		return;
+	}
 
-		bool pixelsAreReady = curFrame.pixState == PixelState::THREAD_FINISHED_LOADING;
+	ofBuffer * encodedCache = encodedCacheBudget > 0 ? &curFrame.encodedBytes : nullptr;
+	job->readOK = readFrameBytes(job->packed.get(), job->frameIndex, getFramePath(pattern, table, job->frameIndex), job->buffer,
+								 encodedCache, &table.encodedCacheBytes, job->data, job->size, true, getPageCacheProbe(&results));
+	results.filesizeKb = job->size / 1024.0f;
+	job->readEndTime = ofGetElapsedTimeMicros();
+	results.readTime = (job->readEndTime - t) / 1000.0f;
+	queueDecode(job, true);
+}
 
-		if(pixelsAreReady){ //1st update() call in which the pixels are available - load to GPU and change state to LOADED
 
-			if(shouldLoadTexture){
+void ofxImageSequenceVideo::submitUringLoad(const Sequence & seq, int frameIndex, double deadline,
+											std::vector<std::unique_ptr<ofxImageSequenceVideoUringReader::Request>> & requests){
 
-				if(curFrame.texState == TextureState::NOT_LOADED){
+	auto job = std::make_shared<PipelineJob>();
+	job->table = seq.table;
+	job->results.generation = seq.table->generation;
+	FrameData & frame = *job->table->data[frameIndex];
+	job->frameIndex = frameIndex;
+	job->packed = seq.packed;
+	job->pattern = seq.pattern;
+	job->dueTime = ofxImageSequenceVideoThreadPool::now() + deadline;
+	job->results.frame = frameIndex;
+	uint64_t t = ofGetElapsedTimeMicros();
 
-					//TS_SCOPE("load 2 GPU");
+	bool encodedTier = encodedCacheBudget > 0 && !seq.packed;
+	if(encodedTier && frame.encodedBytes.size() > 0){ //encoded RAM tier hit, nothing to read
+		encodedCacheHits++;
+		job->data = (const unsigned char *)frame.encodedBytes.getData();
+		job->size = frame.encodedBytes.size();
+		job->readOK = true;
+		job->results.filesizeKb = job->size / 1024.0f;
+		job->readEndTime = t;
+		queueDecode(job, false); //the main thread can't block; the in-flight cap already bounds the decode queue
+		return;
+	}
 
-					if(keepTexturesInGpuMem){ //load into frames vector
-						//TS_START_ACC("load tex KEEP");
-						if(!useDXTCompression){
-							curFrame.texture.loadData(curFrame.pixels);
-						}else{
-							ofxDXT::loadDataIntoTexture(curFrame.compressedPixels, curFrame.texture);
-						}
-						//TS_STOP_ACC("load tex KEEP");
-						curFrame.texState = TextureState::LOADED;
-					}else{ //load into reusable texture
-						//TS_START_ACC("load tex ONE-OFF");
-						if(!useDXTCompression){
-							tex.loadData(curFrame.pixels);
-						}else{
-							ofxDXT::loadDataIntoTexture(curFrame.compressedPixels, tex);
-						}
-						//TS_STOP_ACC("load tex ONE-OFF");
-					}
-				}
+	auto request = std::make_unique<ofxImageSequenceVideoUringReader::Request>();
+	if(seq.packed){
+		const auto & entry = seq.packed->getEntry(frameIndex);
+		request->path = seq.packed->getPath();
+		request->offset = entry.offset;
+		request->size = entry.size;
+		request->fd = seq.packed->getFd(); //the job keeps the packed file, and so its fds, open until the read is done
+		if(uringReader->getDirectIO()) request->directFd = seq.packed->getDirectFd();
+	}else{
+		request->path = ofToDataPath(getFramePath(seq.pattern.get(), *job->table, frameIndex), true);
+	}
+	request->onDone = [this, job, t, encodedTier](ofxImageSequenceVideoUringReader::Request & r){
+		//runs on the ring thread
+		job->readOK = r.ok;
+		job->results.loadOK = r.ok;
+		job->alignedBuffer = r.data;
+		job->data = r.data.get();
+		job->size = r.bytesRead;
+		if(r.ok && encodedTier){ //keep a copy in the encoded RAM tier if it fits
+			encodedCacheMisses++;
+			size_t prevBytes = job->table->encodedCacheBytes.fetch_add(r.bytesRead);
+			if(prevBytes + r.bytesRead <= encodedCacheBudget){
+				ofBuffer & cache = job->table->data[job->frameIndex]->encodedBytes;
+				cache.set((const char *)job->data, job->size);
+				job->data = (const unsigned char *)cache.getData();
+				job->alignedBuffer.reset();
+			}else{
+				job->table->encodedCacheBytes -= r.bytesRead;
 			}
-			curFrame.pixState = PixelState::LOADED;
-			newData = true;
 		}
+		job->results.filesizeKb = job->size / 1024.0f;
+		job->readEndTime = ofGetElapsedTimeMicros();
+		job->results.readTime = (job->readEndTime - t) / 1000.0f;
+		queueDecode(job, false);
+	};
+	requests.emplace_back(std::move(request));
+}
 
-		PixelState state = CURRENT_FRAME_ALT[currentFrame].pixState;
 
-		bool pixelsReady = (state == PixelState::THREAD_FINISHED_LOADING|| state == PixelState::LOADED);
-		bool loop = (shouldLoop || (!shouldLoop && (currentFrame <= (numFrames - 1))));
-		bool isTextureReady = CURRENT_FRAME_ALT[currentFrame].texState == TextureState::LOADED;
+void ofxImageSequenceVideo::queueDecode(std::shared_ptr<PipelineJob> job, bool waitForSlot){
 
-		if(playback && (numFramesToAdvance > 0) && loop && (pixelsReady || isTextureReady)){
-			for(int i = 0; i < numFramesToAdvance; i++){
-				handleScreenTimeCounters(dt);
-				advanceFrameInternal();
-				handleLooping(true);
-			}
+	{ //bounded queue - wait for a free slot, this is the backpressure that keeps I/O from running away from decode
+		std::unique_lock<std::mutex> lock(pipelineMutex);
+		if(waitForSlot){
+			pipelineCondition.wait(lock, [this]{ return numQueuedDecodes < maxQueuedDecodes || pipelineShuttingDown; });
 		}
+		if(pipelineShuttingDown) return; //tearing down, results are discarded anyway
+		numQueuedDecodes++;
+	}
+	double deadline = job->dueTime - ofxImageSequenceVideoThreadPool::now(); //keeps its place in line in the decode pool
+	threadPool->submit(threadPoolClientID, deadline, [this, job](){
+		decodeStage(job);
+	});
+}
 
-		handleLooping(true);
-		handleThreadCleanup();
-		handleThreadSpawn();
 
-		//update buffer statistics
-		int numLoaded = 0;
-		for(int i = 0; i < numBufferFrames; i++){
-			auto state = CURRENT_FRAME_ALT[(currentFrame + i)%numFrames].pixState;
-			auto texState = CURRENT_FRAME_ALT[(currentFrame + i)%numFrames].texState;
-			if(state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED || texState == TextureState::LOADED){
-				numLoaded++;
-			}
-		}
-		bufferFullness = ofLerp(bufferFullness,(numLoaded / float(numBufferFrames)), 0.1);
+void ofxImageSequenceVideo::decodeStage(std::shared_ptr<PipelineJob> job){
 
-	}else{ //immediate mode, we load what we need on demand on the main frame blocking
+	//runs on a decode thread
+	{
+		std::lock_guard<std::mutex> lock(pipelineMutex);
+		numQueuedDecodes--;
+	}
+	pipelineCondition.notify_one();
 
-		if(playback && (frameOnScreenTime >= frameDuration || frameOnScreenTime < 0.0f) &&
-		   (shouldLoop || (!shouldLoop && (currentFrame <= (numFrames - 1))))
-		   ){
+	LoadResults & results = job->results;
+	if(isStale(*job->table)){
+		completedTasks.push(results);
+		return;
+	}
+	uint64_t t = ofGetElapsedTimeMicros();
+	FrameData & curFrame = *job->table->data[job->frameIndex];
+	results.queueWaitTime = (t - job->readEndTime) / 1000.0f;
 
-			int oldFrame = currentFrame;
-			for(int i = 0; i < numFramesToAdvance; i++){
-				handleScreenTimeCounters(dt);
-				advanceFrameInternal();
-				handleLooping(true);
-			}
+	pixelPool.acquire(curFrame.pixels);
+	const unsigned char * buffer = curFrame.pixels.getData();
+	results.loadOK = job->readOK && decodeFromMemory(job->table->fileExtension, job->data, job->size, curFrame.pixels);
+	publishFrame(*job->table, job->frameIndex, buffer, results);
 
-			if(oldFrame != currentFrame){ //data is not new if we are not looping and we are stuck in the last frame
-				newData = true;
-				loadPixelsNow(currentFrame, oldFrame);
-			}
-		}
+	results.decodeTime = (ofGetElapsedTimeMicros() - t) / 1000.0f;
+	results.elapsedTime = results.readTime + results.queueWaitTime + results.decodeTime;
+	completedTasks.push(results);
+}
 
-		if(texNeedsLoad && shouldLoadTexture){
-			texNeedsLoad = false;
-			TS_START_ACC("load pix GPU");
 
-			if(!useDXTCompression){
-				tex.loadData(currentPixels);
-			}else{
-				ofxDXT::loadDataIntoTexture(currentPixelsCompressed, tex);
-			}
-			TS_STOP_ACC("load pix GPU");
+bool ofxImageSequenceVideo::loadFrameData(ofxImageSequenceVideoPackedFile * packed, int frame, const string & filePath,
+										  const string & fileExt, ofPixels & pixels, ofxDXT::Data & compressedPixels,
+										  ofxImageSequenceVideoDXTView & compressedView, LoadResults * results,
+										  ofBuffer * encodedCache, std::atomic<size_t> * encodedCacheBytes){
+
+	uint64_t t = ofGetElapsedTimeMicros();
+	if(!useDXTCompression){ //get the encoded bytes into RAM (the thread's read buffer, unless they are there already), decode from there
+		bool encodedTier = encodedCache && encodedCacheBudget > 0;
+		const unsigned char * data = nullptr;
+		size_t size = 0;
+		if(!readFrameBytes(packed, frame, filePath, encodedFrame, encodedTier ? encodedCache : nullptr, encodedCacheBytes, data, size, false,
+						   getPageCacheProbe(results))){
+			return false;
 		}
+		uint64_t readEndTime = ofGetElapsedTimeMicros();
+		bool ok = decodeFromMemory(fileExt, data, size, pixels);
+		if(results){
+			results->filesizeKb = size / 1024.0f;
+			results->readTime = (readEndTime - t) / 1000.0f;
+			results->decodeTime = (ofGetElapsedTimeMicros() - readEndTime) / 1000.0f;
+		}
+		return ok;
 	}
-}
 
+	if(packed){ //DXT .isv, point the view at the frame's blocks in the mapping (faulting them in here, not on the main thread)
+		const unsigned char * data = nullptr;
+		size_t size = 0;
+		if(!readFrameBytes(packed, frame, filePath, compressedView.buffer, nullptr, nullptr, data, size, true, getPageCacheProbe(results))){
+			return false;
+		}
+		const auto & e = packed->getEntry(frame);
+		compressedView.data = data;
+		compressedView.size = size;
+		compressedView.width = e.width;
+		compressedView.height = e.height;
+		compressedView.compressionType = packed->getDXTCompressionType();
+		if(results){
+			results->filesizeKb = size / 1024.0f;
+			results->readTime = (ofGetElapsedTimeMicros() - t) / 1000.0f;
+		}
+		return true;
+	}
 
-void ofxImageSequenceVideo::setPlaybackFramerate(float framerate){
-	frameDuration = 1.0f / framerate;
+	if(reportFileSize && results){
+		auto myPath = std::filesystem::path(ofToDataPath(filePath, true));
+		try {
+			results->filesizeKb = std::filesystem::file_size(myPath) / 1024.0f;
+		}catch(std::filesystem::filesystem_error& e){}
+	}
+	compressedView.clear(); //not from a packed file, it must not shadow compressedPixels
+	bool ok = ofxDXT::loadFromDisk(filePath, compressedPixels); //ofxDXT only loads from disk, read & decompress in one go
+	if(results) results->readTime = (ofGetElapsedTimeMicros() - t) / 1000.0f;
+	return ok;
 }
 
-void ofxImageSequenceVideo::handleLooping(bool triggerEvents){
 
-	if(shouldLoop){ //loop movie
-		if(currentFrame >= numFrames){
-            if(reverse){
-                currentFrame = numFrames - 1;
-                reversing = true;
-            }else{
-                currentFrame = 0;
-            }
-            
-			if(triggerEvents){
-				EventInfo info;
-				info.who = this;
-				ofNotifyEvent(eventMovieLooped, info, this);
-			}
+bool ofxImageSequenceVideo::readFrameBytes(ofxImageSequenceVideoPackedFile * packed, int frame, const string & filePath,
+										   ofBuffer & buffer, ofBuffer * encodedCache, std::atomic<size_t> * encodedCacheBytes,
+										   const unsigned char *& data, size_t & size, bool prefault, int * pageCacheHit){
+
+	if(packed){ //encoded bytes at the frame's offset
+		if(packed->isMapped()){ //zero copy, point straight into the mapped file
+			if(pageCacheHit) *pageCacheHit = packed->isResident(frame); //before touching it!
+			if(prefault) packed->touchFrame(frame);
+			data = packed->getFrameData(frame);
+			size = packed->getEntry(frame).size;
+			return true;
 		}
-	}else{ //movie stops at last frame
-		if(currentFrame >= numFrames){
-			currentFrame = numFrames - 1;
+		if(!packed->readFrame(frame, buffer, pageCacheHit)){
+			ofLogError("ofxImageSequenceVideo") << "can't read frame " << frame << " from \"" << packed->getPath() << "\"";
+			return false;
 		}
+		data = (const unsigned char *)buffer.getData();
+		size = buffer.size();
+		return true;
 	}
-}
 
+	if(encodedCache && encodedCache->size() > 0){ //encoded RAM tier hit, no disk access at all
+		encodedCacheHits++;
+		data = (const unsigned char *)encodedCache->getData();
+		size = encodedCache->size();
+		return true;
+	}
 
-void ofxImageSequenceVideo::handleThreadCleanup(){
-	//handle thread spawning / cleaning – if any thread is avialable, put it to work
-	for(int i = tasks.size() - 1; i >= 0; i--){
-		//see if thread is done, gather results and remove from vector
-		std::future_status status = tasks[i].wait_for(std::chrono::microseconds(0));
-		if(status == std::future_status::ready){
-			LoadResults results = tasks[i].get();
-			loadTimeAvg = ofLerp(loadTimeAvg, results.elapsedTime, 0.1);
-			if(reportFileSize){
-				if (fileSizeAvgKb <= 0.0f){
-					fileSizeAvgKb = results.filesizeKb;
-				}else{
-					fileSizeAvgKb = ofLerp(fileSizeAvgKb, results.filesizeKb, 0.1);
-				}
-			}
-			if (results.shouldBeDisregaded){
-				FrameInfo & curFrame = CURRENT_FRAME_ALT[results.frame];
-				curFrame.pixels.clear();
-				curFrame.compressedPixels = ofxDXT::Data();
-				curFrame.pixState = PixelState::NOT_LOADED;
-				curFrame.shouldDisregardWhenLoaded = false;
-				//ofLogWarning("ofxImageSequenceVideo") << "thread cleanup frame " << results.frame;
-			}
-			//ofLogNotice("ofxImageSequenceVideo") << ofGetFrameNum() << " - frame loaded! " << frame;
-			tasks.erase(tasks.begin() + i);
+	if(!ofxImageSequenceVideoPackedFile::readFile(filePath, buffer, pageCacheHit)){
+		ofLogError("ofxImageSequenceVideo") << "can't read frame \"" << filePath << "\"";
+		return false;
+	}
+	if(encodedCache){
+		encodedCacheMisses++;
+		size_t prevBytes = encodedCacheBytes->fetch_add(buffer.size());
+		if(prevBytes + buffer.size() <= encodedCacheBudget){
+			std::swap(*encodedCache, buffer); //keep it
+			data = (const unsigned char *)encodedCache->getData();
+			size = encodedCache->size();
+			return true;
 		}
+		*encodedCacheBytes -= buffer.size(); //doesn't fit, undo the reservation and use the temp buffer
 	}
+	data = (const unsigned char *)buffer.getData();
+	size = buffer.size();
+	return true;
 }
 
 
-void ofxImageSequenceVideo::handleScreenTimeCounters(float dt){
-	if(frameOnScreenTime >= 0.0f){
-		frameOnScreenTime -= frameDuration;
-	}else{
-		frameOnScreenTime = dt;
+bool ofxImageSequenceVideo::decodeFromMemory(const string & fileExt, const unsigned char * data, size_t size, ofPixels & pixels){
+
+	switch(getDecoderFor(fileExt)){
+		case Decoder::TURBOJPEG: return decodeTurboJpeg(data, size, pixels);
+		case Decoder::STB: return decodeStb(data, size, pixels);
+		default: break;
 	}
+	//ofLoadImage (FreeImage memory I/O) wants an ofBuffer; the bytes are usually in the thread's read buffer already. If
+	//they aren't (mapped .isv file, encoded RAM tier, pipeline), they are copied into it, which only allocates when it grows
+	if((const char *)data != encodedFrame.getData()) encodedFrame.set((const char *)data, size);
+	ofPixels & decoded = getDecodeBuffer(pixels);
+	return ofLoadImage(decoded, encodedFrame) && finishFrame(decoded, pixels);
 }
 
-void ofxImageSequenceVideo::handleThreadSpawn(){
-    
-    if(playback && currentFrame < 0){
-        currentFrame = 0;
-        reversing = false;
-    }
-    
-	int numToSpawn = numThreads - tasks.size();
-	int frameToLoad = currentFrame;
-	int furthestFrame = currentFrame + numBufferFrames;
-
-	if(bufferFullness > 0.75 && numBufferFrames < CURRENT_FRAME_ALT.size()){ //dont overspawn if we have enough data already - unless we are trying to load the whole sequence
-		numToSpawn = ofClamp(numToSpawn, 0, 1);
+
+ofxImageSequenceVideo::Decoder ofxImageSequenceVideo::getDecoderFor(const string & fileExt){
+
+	string ext = ofToLower(fileExt);
+	bool jpeg = ext == "jpeg" || ext == "jpg";
+	switch(decoder){
+		case Decoder::AUTO:
+		case Decoder::TURBOJPEG:
+			#if defined(USE_TURBO_JPEG)
+			if(jpeg) return Decoder::TURBOJPEG;
+			#endif
+			return Decoder::FREEIMAGE;
+		case Decoder::STB:
+			if(jpeg || ext == "png" || ext == "tga" || ext == "bmp") return Decoder::STB;
+			return Decoder::FREEIMAGE;
+		default:
+			return Decoder::FREEIMAGE;
 	}
+}
 
-	bool fullyLoaded = false;
-	for(int i = 0; i < numToSpawn; i++ ){
-		//look for a frame that needs loading
-		int numChecked = 0;
-		while(CURRENT_FRAME_ALT[frameToLoad%numFrames].pixState != PixelState::NOT_LOADED ){
-			frameToLoad++;
-			numChecked++;
-			if(numChecked >= numFrames){
-				fullyLoaded = true;
-				break;
-			}
-		}
-		if( !fullyLoaded && frameToLoad < furthestFrame ){ //if the frame is within the buffer zone, spawn a thread to load it
-			int moduloFrameToLoad = frameToLoad%numFrames;
-			//ofLogNotice("ofxImageSequenceVideo") << ofGetFrameNum() << " - spawn thread to load frame " << moduloFrameToLoad;
-			//if keeping textures in mem, dont spawn thread to load pixels if textures are already there
-			if( !keepTexturesInGpuMem || (keepTexturesInGpuMem && CURRENT_FRAME_ALT[moduloFrameToLoad].texState != TextureState::LOADED)){
-				CURRENT_FRAME_ALT[moduloFrameToLoad].pixState = PixelState::LOADING;
-				tasks.push_back( std::async(std::launch::async, &ofxImageSequenceVideo::loadFrameThread, this, moduloFrameToLoad) );
-			}
-		}
+
+string ofxImageSequenceVideo::getDecoderName(Decoder decoder){
+	switch(decoder){
+		case Decoder::AUTO: return "Auto";
+		case Decoder::FREEIMAGE: return "FreeImage";
+		case Decoder::TURBOJPEG: return "TurboJpeg";
+		case Decoder::STB: return "stb_image";
 	}
+	return "";
 }
 
 
-ofxImageSequenceVideo::LoadResults ofxImageSequenceVideo::loadFrameThread(int frame){
+#if defined(USE_TURBO_JPEG)
 
-	uint64_t t = ofGetElapsedTimeMicros();
-	FrameInfo & curFrame = CURRENT_FRAME_ALT[frame];
-	LoadResults results;
+bool ofxImageSequenceVideo::decodeTurboJpeg(const unsigned char * data, size_t size, ofPixels & pixels){
 
-	if(reportFileSize){
-		auto myPath = std::filesystem::path(ofToDataPath(curFrame.filePath, true));
-		try {
-			results.filesizeKb = std::filesystem::file_size(myPath) / 1024.0f;
-		}catch(std::filesystem::filesystem_error& e){}
+	tjhandle tj = turboJpegDecoder.get();
+	if(!tj){
+		ofLogError("ofxImageSequenceVideo") << "can't create a turbojpeg decompressor";
+		return false;
 	}
-	if(!useDXTCompression){
-		#if defined(USE_TURBO_JPEG)
-		if(fileExtension == "jpeg" || fileExtension == "jpg"){
-			ofxTurboJpeg jpeg;
-			jpeg.load(curFrame.pixels, curFrame.filePath);
-		}else{
-			ofLoadImage(curFrame.pixels, curFrame.filePath);
+	int w, h, subsamp, colorspace;
+	bool ok = tjDecompressHeader3(tj, data, size, &w, &h, &subsamp, &colorspace) == 0;
+	if(ok){
+		tjscalingfactor scale = {1, ofxImageSequenceVideoScale::getFactor(w, h, targetWidth, targetHeight)};
+		w = TJSCALED(w, scale); //tjDecompress2() picks the DCT scaling that gives this size
+		h = TJSCALED(h, scale);
+		ofPixelFormat format = OF_PIXELS_RGB;
+		int tjFormat = TJPF_RGB;
+		if(outputPixelFormat == OF_PIXELS_RGBA || outputPixelFormat == OF_PIXELS_BGRA){ //alpha comes out as 255
+			format = outputPixelFormat;
+			tjFormat = format == OF_PIXELS_RGBA ? TJPF_RGBA : TJPF_BGRA;
 		}
-		#else
-			ofLoadImage(curFrame.pixels, curFrame.filePath);
-		#endif
+		pixels.allocate(w, h, format);
+		ok = tjDecompress2(tj, data, size, pixels.getData(), w, 0, h, tjFormat, TJFLAG_FASTDCT) == 0;
+	}
+	return ok;
+}
+
+#else
+
+bool ofxImageSequenceVideo::decodeTurboJpeg(const unsigned char *, size_t, ofPixels &){
+	return false; //never picked without turbojpeg, see getDecoderFor()
+}
+
+#endif
+
+
+bool ofxImageSequenceVideo::decodeStb(const unsigned char * data, size_t size, ofPixels & pixels){
+
+	//stb can add / drop channels as it decodes, so ask for the output format's if it's one stb has (BGRA isn't)
+	int numChannels = 0;
+	if(outputPixelFormat == OF_PIXELS_RGBA) numChannels = 4;
+	else if(outputPixelFormat == OF_PIXELS_RGB) numChannels = 3;
+
+	int w, h, fileChannels;
+	unsigned char * stbPixels = stbi_load_from_memory(data, (int)size, &w, &h, &fileChannels, numChannels);
+	if(!stbPixels){
+		ofLogError("ofxImageSequenceVideo") << "stb_image can't decode frame: " << stbi_failure_reason();
+		return false;
+	}
+	if(numChannels == 0) numChannels = fileChannels;
+
+	//stb always decodes into a buffer of its own. If there's a post decode stage it reads from there, otherwise the
+	//frame is copied into pixels (a pooled buffer that allocate() keeps as is)
+	ofPixelFormat format = numChannels == 4 ? OF_PIXELS_RGBA : numChannels == 3 ? OF_PIXELS_RGB :
+						   numChannels == 2 ? OF_PIXELS_GRAY_ALPHA : OF_PIXELS_GRAY;
+	if(needsPostDecodeStage(w, h, format)){
+		ofPixels stbFrame;
+		stbFrame.setFromExternalPixels(stbPixels, w, h, format);
+		finishFrame(stbFrame, pixels);
 	}else{
-		ofxDXT::loadFromDisk(curFrame.filePath, curFrame.compressedPixels);
+		pixels.allocate(w, h, format);
+		memcpy(pixels.getData(), stbPixels, (size_t)w * h * numChannels);
 	}
+	stbi_image_free(stbPixels);
+	return true;
+}
 
-	//ofSleepMillis(130); //testing large assets
 
-	results.shouldBeDisregaded = curFrame.shouldDisregardWhenLoaded;
+ofPixels & ofxImageSequenceVideo::getDecodeBuffer(ofPixels & pixels){
+	return (isDecodingToTarget() || outputPixelFormat != OF_PIXELS_UNKNOWN) ? decodedFrame : pixels;
+}
 
-	//test if the loading finished too late, if so, set this frame to be disregarded
-	int low = currentFrame;
-	int high = (currentFrame + numBufferFrames) % numFrames;
-	if(low < high){ //normal case, no timeleline split
-		if(frame < low || frame > high){
-			//ofLogWarning("ofxImageSequenceVideo") << "case A: we should delete frame " << frame << " dis: " << results.shouldBeDisregaded ;
-			results.shouldBeDisregaded |= true;
-		}
-	}else{ // split case, buffer is ahead and looped back to zero
-		if(frame > high && frame < low){
-			//ofLogWarning("ofxImageSequenceVideo") << "case B RIGHT: we should delete frame " << frame << " dis: " << results.shouldBeDisregaded ;
-			results.shouldBeDisregaded |= true;
-		}
+
+bool ofxImageSequenceVideo::needsPostDecodeStage(int width, int height, ofPixelFormat format){
+	return ofxImageSequenceVideoScale::getFactor(width, height, targetWidth, targetHeight) > 1 ||
+		   (outputPixelFormat != format && ofxImageSequenceVideoPixelConvert::canConvert(format, outputPixelFormat));
+}
+
+
+bool ofxImageSequenceVideo::finishFrame(ofPixels & decoded, ofPixels & pixels){
+
+	if(&decoded == &pixels) return true;
+	ofPixels * frame = &decoded;
+	bool convert = outputPixelFormat != decoded.getPixelFormat() &&
+				   ofxImageSequenceVideoPixelConvert::canConvert(decoded.getPixelFormat(), outputPixelFormat);
+
+	int factor = ofxImageSequenceVideoScale::getFactor(decoded.getWidth(), decoded.getHeight(), targetWidth, targetHeight);
+	if(factor > 1){ //scale 1st, so there are less pixels to convert
+		ofPixels & scaled = convert ? scaledFrame : pixels;
+		ofxImageSequenceVideoScale::boxDownscale(decoded, scaled, factor);
+		frame = &scaled;
 	}
 
-	//update state, prepare report
-	curFrame.pixState = PixelState::THREAD_FINISHED_LOADING;
-	t = ofGetElapsedTimeMicros() - t;
-	results.elapsedTime = t / 1000.0f;
-	results.frame = frame;
-	return results;
+	if(convert){
+		ofxImageSequenceVideoPixelConvert::convert(*frame, pixels, outputPixelFormat);
+	}else if(frame != &pixels){ //nothing to do after all. Copied, not swapped: pixels is a pooled buffer, and the decode
+								//buffer is this thread's; swapping would move buffers between the pool and the threads
+		pixels.allocate(frame->getWidth(), frame->getHeight(), frame->getPixelFormat());
+		memcpy(pixels.getData(), frame->getData(), frame->getTotalBytes());
+	}
+	return true;
 }
 
 
 void ofxImageSequenceVideo::eraseAllPixelCache(){
 
+	FrameTable & table = *frameTable;
 	for(int i = 0; i < numFrames; i++){
-		FrameInfo & curFrame = CURRENT_FRAME_ALT[i];
-		if(curFrame.pixState == PixelState::THREAD_FINISHED_LOADING || curFrame.pixState == PixelState::LOADED){
-			curFrame.pixels.clear();
+		PixelState state = table.pixState[i];
+		if(state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED){
 			//curFrame.compressedPixels.clear(); //note that because ofBuffer internally holds a vector, even if you
 												//clear the ofBuffer, the vector class keeps its "capacity" allocation
 												//which means it will not release its RAM. That's why we destroy the obj
 												//alltogether
-			curFrame.compressedPixels = ofxDXT::Data();
-			curFrame.pixState = PixelState::NOT_LOADED;
+			releasePixels(i);
 		}
 	}
 }
 
 void ofxImageSequenceVideo::eraseAllTextureCache(){
 
-	for(int i = 0; i < numFrames; i++){
-		FrameInfo & curFrame = CURRENT_FRAME_ALT[i];
-		if(curFrame.texState == TextureState::LOADED ){
-			curFrame.texture.clear();
-			curFrame.texState = TextureState::NOT_LOADED;
-		}
+	FrameTable & table = *frameTable;
+	for(int frame : residentTextures){ //only kept textures can be loaded
+		table.data[frame]->texture.clear();
+		table.texState[frame] = TextureState::NOT_LOADED;
+		table.releaseData(frame);
 	}
+	residentTextures.clear();
+}
+
+
+void ofxImageSequenceVideo::setMemoryBudget(size_t ramBytes, size_t vramBytes){
+	ramBudget = ramBytes;
+	vramBudget = vramBytes;
+	if(loaded) trimTextureCache();
+}
+
+
+float ofxImageSequenceVideo::getEncodedCacheHitRate(){
+	uint64_t total = encodedCacheHits + encodedCacheMisses;
+	return total > 0 ? encodedCacheHits / double(total) : 0.0f;
 }
 
-void ofxImageSequenceVideo::eraseOutOfBufferPixelCache(){
 
-	int start = 0;
-	if(currentFrame + numBufferFrames > numFrames){
-		start = numBufferFrames - (numFrames - currentFrame);
+size_t ofxImageSequenceVideo::getVramUse(){
+	return residentTextures.size() * textureBytes;
+}
+
+
+int ofxImageSequenceVideo::getBufferLength(){
+	if(ramBudget > 0 && decodedFrameBytes > 0){
+		//the window gets what the other RAM users leave. The pool's spare buffers are all allocated at once (see
+		//handleThreadCleanup()) and explicit preroll frames are held until the switch, so both are reserved whole
+		size_t numReserved = (useDXTCompression ? 0 : pixelPool.getMaxBuffers()) + (nextSequence ? numPrerollFrames : 0);
+		size_t reserved = numReserved * decodedFrameBytes + getEncodedCacheUse();
+		size_t numFit = ramBudget > reserved ? (ramBudget - reserved) / decodedFrameBytes : 0;
+		return ofClamp(numFit, 1, MAX(numFrames, 1));
 	}
+	return numBufferFrames;
+}
 
-	for(int i = start; i < currentFrame; i++){
-		FrameInfo & curFrame = CURRENT_FRAME_ALT[i];
-		if(curFrame.pixState == PixelState::THREAD_FINISHED_LOADING || curFrame.pixState == PixelState::LOADED){
-			curFrame.pixels.clear();
-			curFrame.compressedPixels = ofxDXT::Data(); //clear pixels data
-			curFrame.pixState = PixelState::NOT_LOADED;
-		}
-		if(curFrame.pixState == PixelState::LOADING){
-			curFrame.shouldDisregardWhenLoaded = true;
-			ofLogWarning("ofxImageSequenceVideo") << "set to erase later frame " << i;
+
+size_t ofxImageSequenceVideo::getRamUse(){
+	int64_t decoded = 0;
+	if(frameTable) decoded += frameTable->ramBytesInUse;
+	if(nextSequence) decoded += nextSequence->table->ramBytesInUse;
+	return MAX(decoded, 0) + pixelPool.getFreeBytes() + getEncodedCacheUse();
+}
+
+
+size_t ofxImageSequenceVideo::getEncodedCacheUse(){
+	size_t bytes = frameTable ? frameTable->encodedCacheBytes.load() : 0;
+	if(nextSequence) bytes += nextSequence->table->encodedCacheBytes;
+	return bytes;
+}
+
+
+size_t ofxImageSequenceVideo::getFrameBytes(FrameData & frame){
+	if(frame.pixels.isAllocated()) return frame.pixels.getTotalBytes();
+	if(frame.compressedView.isSet()) return frame.compressedView.size; //mapped pages, resident until the frame is dropped
+	return frame.compressedPixels.size();
+}
+
+
+void ofxImageSequenceVideo::loadDXTIntoTexture(ofxDXT::Data & data, const ofxImageSequenceVideoDXTView & view, ofTexture & texture){
+	if(view.isSet()){
+		view.loadIntoTexture(texture);
+	}else{
+		ofxDXT::loadDataIntoTexture(data, texture);
+	}
+}
+
+
+void ofxImageSequenceVideo::trimTextureCache(){
+
+	if(vramBudget == 0 || textureBytes == 0) return; //no budget, keep them all
+
+	int direction = getPlaybackDirection();
+	while(getVramUse() > vramBudget && residentTextures.size() > 1){
+		//the texture needed last is the one closest behind the playhead (in playback direction)
+		std::set<int>::iterator victim;
+		if(direction > 0){
+			victim = residentTextures.lower_bound(currentFrame);
+			if(victim == residentTextures.begin()) victim = residentTextures.end();
+			victim--;
+		}else{
+			victim = residentTextures.upper_bound(currentFrame);
+			if(victim == residentTextures.end()) victim = residentTextures.begin();
 		}
+		if(*victim == currentFrame) break; //never drop what's on screen
+		FrameTable & table = *frameTable;
+		table.data[*victim]->texture.clear();
+		table.texState[*victim] = TextureState::NOT_LOADED;
+		table.releaseData(*victim);
+		residentTextures.erase(victim);
 	}
+}
+
+void ofxImageSequenceVideo::eraseOutOfBufferPixelCache(){
 
-	for(int i = currentFrame + numBufferFrames; i < numFrames; i++){
-		FrameInfo & curFrame = CURRENT_FRAME_ALT[i];
-		if(curFrame.pixState == PixelState::THREAD_FINISHED_LOADING || curFrame.pixState == PixelState::LOADED){
-			curFrame.pixels.clear();
-			curFrame.compressedPixels = ofxDXT::Data(); //clear pixels data
-			curFrame.pixState = PixelState::NOT_LOADED;
+	updateBufferWindow();
+	FrameTable & table = *frameTable;
+	for(int i = 0; i < numFrames; i++){
+		//idle frames are the vast majority, the packed state array lets us skip them without touching anything else
+		if(table.pixState[i].load(std::memory_order_relaxed) == PixelState::NOT_LOADED) continue;
+		if(!isFrameInBuffer(i)){
+			erasePixelCache(i);
 		}
-		if(curFrame.pixState == PixelState::LOADING){
-			curFrame.shouldDisregardWhenLoaded = true;
-			ofLogWarning("ofxImageSequenceVideo") << "set to erase later frame " << i;
+	}
+}
+
+
+void ofxImageSequenceVideo::erasePixelCache(int frame){
+
+	std::atomic<PixelState> & pixState = frameTable->pixState[frame];
+	PixelState state = pixState.load(std::memory_order_acquire);
+	if(state == PixelState::LOADING){
+		//a worker owns the pixels - ask for them to be dropped when it's done
+		if(pixState.compare_exchange_strong(state, PixelState::DISREGARDED, std::memory_order_acq_rel)){
+			return;
 		}
+		//else the worker just published them (state now holds THREAD_FINISHED_LOADING), they are ours to free
+	}
+	if(state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED){
+		releasePixels(frame);
 	}
 }
 
 
+void ofxImageSequenceVideo::releasePixels(FrameTable & table, int frame){
+	table.pixState[frame].store(PixelState::NOT_LOADED, std::memory_order_relaxed);
+	FrameData * data = table.data[frame];
+	if(!data) return;
+	table.ramBytesInUse -= getFrameBytes(*data);
+	pixelPool.release(data->pixels);
+	data->compressedPixels = ofxDXT::Data(); //clear pixels data
+	data->compressedView.clear();
+	table.releaseData(frame); //unless it still holds a texture or encoded bytes
+}
+
+
 void ofxImageSequenceVideo::setReportFileSize(bool report){
 	reportFileSize = report;
 }
@@ -591,15 +1961,46 @@ std::string ofxImageSequenceVideo::getStatus(){
 
 	msg += "\nMovieDuration: " + secondsToHumanReadable(getMovieDuration(), 2);
 	if(numThreads > 0) msg += string("\nNumTasks: ") + getNumTasks();
+	if(threadPool && useSharedScheduler) msg += "\nSchedulerShare: " + ofToString(100 * getSchedulerShare(), 1) + "% of " + ofToString(threadPool->getNumThreads()) + " threads";
 
-	if(numThreads > 0) msg += "\nBuffer: " + ofToString(100 * bufferFullness, 1) + "% [" + ofToString(numBufferFrames) + "]";
+	if(numThreads > 0) msg += "\nBuffer: " + ofToString(100 * bufferFullness, 1) + "% [" + ofToString(getBufferLength()) + "]";
+	if(numThreads > 0) msg += "\nRAM: " + ofToString(getRamUse() / float(1024 * 1024), 1) + " Mb" + (ramBudget ? " / " + ofToString(ramBudget / float(1024 * 1024), 1) + " Mb" : "");
+	if(encodedCacheBudget > 0) msg += "\nEncodedCache: " + ofToString(getEncodedCacheUse() / float(1024 * 1024), 1) + " / " + ofToString(encodedCacheBudget / float(1024 * 1024), 1) + " Mb, " + ofToString(100 * getEncodedCacheHitRate(), 1) + "% hits";
+	if(shouldKeepTextures()) msg += "\nVRAM: " + ofToString(getVramUse() / float(1024 * 1024), 1) + " Mb" + (vramBudget ? " / " + ofToString(vramBudget / float(1024 * 1024), 1) + " Mb" : "");
 	msg += "\nLoadTimeAvg: " + ofToString(loadTimeAvg, 2) + "ms";
+	if(uringReader){
+		msg += "\nIoUring: " + ofToString(uringReader->getNumBatches()) + " batches, " + ofToString(uringReader->getAvgBatchSize(), 1) + " reads/batch" + (uringReader->getDirectIO() ? ", O_DIRECT" : "");
+	}
+	if(ioPool || uringReader){
+		int numQueued;
+		{
+			std::lock_guard<std::mutex> lock(pipelineMutex);
+			numQueued = numQueuedDecodes;
+		}
+		msg += "\nPipeline: " + (uringReader ? string("io_uring") : ofToString(numIoThreads) + " I/O threads") + ", " + ofToString(numQueued) + "/" + ofToString(maxQueuedDecodes) + " queued";
+		msg += "\nRead: " + ofToString(readTimeAvg, 2) + "ms QueueWait: " + ofToString(queueWaitAvg, 2) + "ms Decode: " + ofToString(decodeTimeAvg, 2) + "ms";
+	}else if(numThreads > 0){
+		msg += "\nRead: " + ofToString(readTimeAvg, 2) + "ms Decode: " + ofToString(decodeTimeAvg, 2) + "ms";
+	}
+	if(numThreads > 0 && !useDXTCompression) msg += "\nPixelAllocs: " + ofToString(pixelPool.getNumAllocations()) + " Recycled: " + ofToString(pixelPool.getNumReuses());
+	if(readaheadDistance > 0) msg += "\nReadahead: " + ofToString(readaheadDistance.load()) + " frames, PageCacheHits: " + ofToString(100 * getPageCacheHitRate(), 1) + "%";
 	if(reportFileSize) msg += "\nFileSizeAvg: " + ofToString(fileSizeAvgKb, 1) + " Kb";
+	if(numMissingFrames > 0) msg += "\nMissingFrames: " + ofToString(numMissingFrames);
+	if(playlist.size()) msg += "\nPlaylist: " + ofToString(playlistIndex + 1) + "/" + ofToString(playlist.size()) + (loopPlaylist ? " (loop)" : "");
+	if(nextSequence) msg += "\nQueued: \"" + nextSequence->path + "\" prerolled: " + ofToString(getNumPrerolledFrames()) + " frames";
+	if(numTransitions > 0) msg += "\nTransitions: " + ofToString(numTransitions) + " Stalls: " + ofToString(numTransitionStalls) +
+								  (numTransitionStalls ? " (last " + ofToString(1000 * lastTransitionStallTime, 1) + "ms)" : "");
 	msg += "\nFrameRate: " + ofToString(1.0 / frameDuration, 2) + "fps";
 	msg += "\nFile Format: " + fileExtension;
 	auto & texture = getTexture();
 	msg += "\nRes: " + ofToString(texture.getWidth(),0) + " x " + ofToString(texture.getHeight(),0);
-	msg += "\nKeepInGPU: " + string(keepTexturesInGpuMem ? "YES" : "FALSE");
+	if(isDecodingToTarget() && !useDXTCompression) msg += " (target " + ofToString(targetWidth) + " x " + ofToString(targetHeight) + ")";
+	if(decoder != Decoder::AUTO && !useDXTCompression) msg += "\nDecoder: " + getDecoderName(decoder);
+	if(outputPixelFormat != OF_PIXELS_UNKNOWN && !useDXTCompression){
+		msg += "\nOutputFormat: " + ofxImageSequenceVideoPixelConvert::getFormatName(outputPixelFormat) + " (" +
+				ofxImageSequenceVideoPixelConvert::getIsaName(ofxImageSequenceVideoPixelConvert::AUTO) + ")";
+	}
+	msg += "\nKeepInGPU: " + string(shouldKeepTextures() ? "YES" : "FALSE");
 
 	return msg;
 }
@@ -610,20 +2011,17 @@ std::string ofxImageSequenceVideo::getBufferStatus(int extendBeyondBuffer){
 	string msg = "[";
 	if(numThreads > 0 && numFrames > 0){  //buffer only for threaded mode
 
-		int numAhead = numBufferFrames + extendBeyondBuffer;
-		//see if buffer hits the end of the clip - we need to wrap then
-		if(currentFrame + numBufferFrames > numFrames) numAhead = numFrames - currentFrame + extendBeyondBuffer;
-		vector<int> framesToTest;
-		for(int i = 0; i < numBufferFrames + extendBeyondBuffer; i++){
-			framesToTest.push_back((currentFrame + i) % numFrames);
-		}
+		vector<int> framesToTest; //in playback order
+		getUpcomingFrames(getBufferLength() + extendBeyondBuffer, framesToTest);
 
 		for(auto & frameNum : framesToTest){
-			switch (CURRENT_FRAME_ALT[frameNum].pixState) {
+			switch (frameTable->pixState[frameNum].load()) {
 				case PixelState::NOT_LOADED: 					msg += "0"; break;
 				case PixelState::LOADING: 						msg += "-"; break;
 				case PixelState::THREAD_FINISHED_LOADING: 		msg += "1"; break;
 				case PixelState::LOADED: 						msg += "1"; break;
+				case PixelState::DISREGARDED: 					msg += "x"; break;
+				case PixelState::FAILED: 						msg += "!"; break;
 			}
 		}
 	}
@@ -637,16 +2035,11 @@ std::string ofxImageSequenceVideo::getGpuBufferStatus(int extendBeyondBuffer){
 	string msg = "[";
 	if(numThreads > 0 && numFrames > 0){  //buffer only for threaded mode
 
-		int numAhead = numBufferFrames + extendBeyondBuffer;
-		//see if buffer hits the end of the clip - we need to wrap then
-		if(currentFrame + numBufferFrames > numFrames) numAhead = numFrames - currentFrame + extendBeyondBuffer;
-		vector<int> framesToTest;
-		for(int i = 0; i < numBufferFrames + extendBeyondBuffer; i++){
-			framesToTest.push_back((currentFrame + i) % numFrames);
-		}
+		vector<int> framesToTest; //in playback order
+		getUpcomingFrames(getBufferLength() + extendBeyondBuffer, framesToTest);
 
 		for(auto & frameNum : framesToTest){
-			switch (CURRENT_FRAME_ALT[frameNum].texState) {
+			switch (frameTable->texState[frameNum]) {
 				case TextureState::NOT_LOADED: 					msg += "0"; break;
 				case TextureState::LOADED: 						msg += "1"; break;
 			}
@@ -667,7 +2060,8 @@ void ofxImageSequenceVideo::drawDebug(float x, float y, float w){
 	ofPushMatrix();
 	ofTranslate(x, y);
 
-	float step = w / CURRENT_FRAME_ALT.size();
+	FrameTable & table = *frameTable;
+	float step = w / table.numFrames;
 	float sw = step * 0.7;
 	float pad = step - sw;
 	float h = sw;
@@ -676,11 +2070,9 @@ void ofxImageSequenceVideo::drawDebug(float x, float y, float w){
 
 	if(numThreads > 0){  //draw buffer zone
 		ofSetColor(255,128);
-		int numAhead = numBufferFrames;
-		//see if buffer hits the end of the clip - we need to wrap then
-		if(currentFrame + numBufferFrames > numFrames) numAhead = numFrames - currentFrame;
-		ofDrawRectangle(step * currentFrame, -h, step * numAhead, h * 3 );
-		if(numAhead != numBufferFrames) ofDrawRectangle(0, -h, step * (numBufferFrames - numAhead), h * 3 );
+		for(int frame : bufferWindow){ //buffer follows playback direction, it might be split around the ends
+			ofDrawRectangle(step * frame, -h, step, h * 3 );
+		}
 		ofSetColor(0);
 		ofDrawRectangle(0, - h * 0.25, w, h * 1.5);
 		ofSetColor(255);
@@ -688,21 +2080,20 @@ void ofxImageSequenceVideo::drawDebug(float x, float y, float w){
 
 	ofColor c;
 	for(int i = 0; i < numFrames; i++){
-		switch (CURRENT_FRAME_ALT[i].pixState) {
+		switch (table.pixState[i].load(std::memory_order_relaxed)) {
 			case PixelState::NOT_LOADED: c = ofColor(99); break; //gray
 			case PixelState::LOADING: c = ofColor(255,255,0); break; //yellow
 			case PixelState::THREAD_FINISHED_LOADING: c = ofColor(0,255,0); break; //green
 			case PixelState::LOADED: c = ofColor(255,0,255); break; //magenta
-		}
-		if(CURRENT_FRAME_ALT[i].shouldDisregardWhenLoaded){
-			c = ofColor::orange;
+			case PixelState::DISREGARDED: c = ofColor::orange; break;
+			case PixelState::FAILED: c = ofColor(255,0,0); break; //red
 		}
 		//ofDrawRectangle(pad * 0.5f + i * step, 0, sw, h);
 		m.addColor(c);
 		float x = pad * 0.5f + i * step + sw * 0.5f;
 		m.addVertex( glm::vec3(x, 0, 0) );
 
-		switch (CURRENT_FRAME_ALT[i].texState) {
+		switch (table.texState[i]) {
 			case TextureState::NOT_LOADED: c = ofColor(255, 100, 100); break;
 			case TextureState::LOADED: c = ofColor(30,190,200); break; //magenta
 		}
@@ -726,26 +2117,17 @@ void ofxImageSequenceVideo::advanceFrameInternal(){
 	if(!loaded) return;
 
 	if(numThreads > 0){ //ASYNC
-		auto & curFrame = CURRENT_FRAME_ALT[currentFrame];
-		bool loaded = (curFrame.pixState == PixelState::THREAD_FINISHED_LOADING || curFrame.pixState == PixelState::LOADED);
-		if(loaded && (curFrame.pixels.isAllocated() || curFrame.compressedPixels.size() > 0)){ //unload old pixels
-			curFrame.pixState = PixelState::NOT_LOADED;
-			curFrame.pixels.clear();
-			curFrame.compressedPixels = ofxDXT::Data(); //clear pixels data
-		}
-	}
-
-    if(reversing)
-    {
-        currentFrame--;
-    }
-    else
-    {
-        currentFrame++;
-    }
-	
-
-	if(!shouldLoop && currentFrame >= numFrames -1){
+		PixelState state = frameTable->pixState[currentFrame];
+		bool loaded = (state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED);
+		if(loaded){ //unload old pixels
+			releasePixels(currentFrame);
+		}
+	}
+
+	int direction = getPlaybackDirection();
+	currentFrame += direction;
+
+	if(!shouldLoop && !nextSequence && ((direction > 0 && currentFrame >= numFrames - 1) || (direction < 0 && currentFrame <= 0))){
 		EventInfo info;
 		info.who = this;
         playback = false;
@@ -757,8 +2139,11 @@ void ofxImageSequenceVideo::advanceFrameInternal(){
 void ofxImageSequenceVideo::advanceOneFrame(){
 	if(!loaded) return;
 	int oldFrame = currentFrame;
+	uint32_t oldGeneration = frameTable->generation;
 	advanceFrameInternal();
 	handleLooping(false);
+	if(frameTable->generation != oldGeneration) oldFrame = -1; //switched to the queued sequence
+	if(playlistNeedsQueue) queueNextPlaylistItem();
 	if(numThreads > 0){
 		eraseOutOfBufferPixelCache();
 	}else{ //immediate mode - load frame right here
@@ -790,33 +2175,24 @@ void ofxImageSequenceVideo::loadPixelsNow(int newFrame, int oldFrame){
 	if(currentFrame != oldFrame || (!tex.isAllocated() && shouldLoadTexture)){
 		uint64_t t = ofGetElapsedTimeMicros();
 
+		FrameTable & table = *frameTable;
 		if(oldFrame >= 0){
-			CURRENT_FRAME_ALT[oldFrame].pixState = PixelState::NOT_LOADED;
-		}
-		auto & newFrameData = CURRENT_FRAME_ALT[newFrame];
-		if(!useDXTCompression){
-			#if defined(USE_TURBO_JPEG)
-			if(fileExtension == "jpeg" || fileExtension == "jpg"){
-				//TS_START_ACC("load jpg disk");
-				ofxTurboJpeg jpeg;
-				jpeg.load(currentPixels, newFrameData.filePath);
-				//TS_STOP_ACC("load jpg disk");
-			}else{
-				//TS_START_ACC("load pix disk");
-				ofLoadImage(currentPixels, newFrameData.filePath);
-				//TS_STOP_ACC("load pix disk");
-			}
-			#else
-			//TS_START_ACC("load pix disk");
-			ofLoadImage(currentPixels, newFrameData.filePath); //load pixels from disk
-			//TS_STOP_ACC("load pix disk");
-			#endif
-		}else{
-			ofxDXT::loadFromDisk(newFrameData.filePath, currentPixelsCompressed);
+			table.pixState[oldFrame] = PixelState::NOT_LOADED;
+			table.releaseData(oldFrame);
 		}
-		newFrameData.pixState = PixelState::LOADED;
+		//only the encoded RAM tier keeps anything per frame in immediate mode
+		ofBuffer * encodedCache = encodedCacheBudget > 0 ? &table.acquireData(newFrame).encodedBytes : nullptr;
+		//TS_START_ACC("load pix disk");
+		bool ok = !isFrameMissing(newFrame) && loadFrameData(packedFile.get(), newFrame, getFramePath(framePattern.get(), table, newFrame),
+								fileExtension, currentPixels, currentPixelsCompressed, currentCompressedView, nullptr, encodedCache, &table.encodedCacheBytes);
+		//TS_STOP_ACC("load pix disk");
+		table.pixState[newFrame] = PixelState::LOADED;
 		loadTimeAvg = ofLerp(loadTimeAvg, (ofGetElapsedTimeMicros() - t) / 1000.0f, 0.1);
-		texNeedsLoad = true;
+		if(ok){
+			texNeedsLoad = true;
+		}else if(!isFrameMissing(newFrame)){ //keep showing the last good frame
+			handleMissingFrame(newFrame);
+		}
 	}
 }
 
@@ -865,7 +2241,7 @@ int ofxImageSequenceVideo::getNumFrames(){
 int ofxImageSequenceVideo::getNumBufferFrames(){
 	if(!loaded) return -1;
 	if(numThreads == 0) return 0;
-	return numBufferFrames;
+	return getBufferLength();
 }
 
 
@@ -880,6 +2256,14 @@ void ofxImageSequenceVideo::setLoop(bool loop){
 	shouldLoop = loop;
 }
 
+void ofxImageSequenceVideo::setPlaybackSpeed(float speed){
+	bool flipped = (speed < 0.0f) != (playbackSpeed < 0.0f);
+	playbackSpeed = speed;
+	if(flipped && loaded && numThreads > 0){ //frames decoded ahead in the old direction are behind us now, free them
+		eraseOutOfBufferPixelCache();
+	}
+}
+
 void ofxImageSequenceVideo::seekToFrame(int frame){
 	if(!loaded) return;
 	int oldFrame = ofClamp(currentFrame, 0, numFrames-1);
@@ -899,9 +2283,9 @@ ofPixels& ofxImageSequenceVideo::getPixels(){
 	if(!loaded) return pix;
 	else{
 		if(numThreads > 0){
-			auto & curFrame = CURRENT_FRAME_ALT[currentFrame];
-			if(curFrame.pixState == PixelState::THREAD_FINISHED_LOADING || curFrame.pixState == PixelState::LOADED){
-				return curFrame.pixels;
+			PixelState state = frameTable->pixState[currentFrame];
+			if(state == PixelState::THREAD_FINISHED_LOADING || state == PixelState::LOADED){
+				return frameTable->data[currentFrame]->pixels;
 			}else{
 				return pix;
 			}
@@ -914,12 +2298,10 @@ ofPixels& ofxImageSequenceVideo::getPixels(){
 
 bool ofxImageSequenceVideo::areAllTexturesPreloaded(){
 
-	if(!keepTexturesInGpuMem) return false;
+	if(!shouldKeepTextures()) return false;
 	else{
-		for(auto & f : frames[currentFrameSet]){
-			if(f.texState == TextureState::NOT_LOADED) return false;
-		}
-		return true;
+		auto & texState = frameTable->texState; //packed, 1 byte per frame
+		return std::find(texState.begin(), texState.end(), TextureState::NOT_LOADED) == texState.end();
 	}
 }
 
@@ -931,16 +2313,17 @@ ofTexture& ofxImageSequenceVideo::getTexture(){
 	if(numThreads == 0){ //inmedate mode
 		return tex;
 	}else{
-		if(keepTexturesInGpuMem){
-			if(CURRENT_FRAME_ALT[currentFrame].texState == TextureState::LOADED){
-				return CURRENT_FRAME_ALT[currentFrame].texture;
+		if(shouldKeepTextures()){
+			if(frameTable->texState[currentFrame] == TextureState::LOADED){
+				return frameTable->data[currentFrame]->texture;
 			}else{
-				int prevFrame = currentFrame - 1;
+				int prevFrame = currentFrame - getPlaybackDirection();
 				if (prevFrame < 0 ) prevFrame = numFrames - 1;
-				if(CURRENT_FRAME_ALT[prevFrame].texState == TextureState::LOADED){
-					return CURRENT_FRAME_ALT[prevFrame].texture;
+				if (prevFrame >= numFrames) prevFrame = 0;
+				if(frameTable->texState[prevFrame] == TextureState::LOADED){
+					return frameTable->data[prevFrame]->texture;
 				}else{
-					return nulltex;
+					return tex; //empty, unless we just switched to a queued sequence (holds the last frame of the previous one)
 				}
 			}
 		}else{
@@ -974,5 +2357,3 @@ char ofxImageSequenceVideo::asciitolower(char in){
 	return in;
 }
 
-
-#undef CURRENT_FRAME_ALT
@@ -8,9 +8,18 @@
 
 #pragma once
 #include "ofMain.h"
-#include <future>
+#include <set>
 
 #include "ofxDXT.h"
+#include "ofxImageSequenceVideoThreadPool.h"
+#include "ofxImageSequenceVideoMPSCQueue.h"
+#include "ofxImageSequenceVideoPackedFile.h"
+#include "ofxImageSequenceVideoDXTView.h"
+#include "ofxImageSequenceVideoPixelPool.h"
+#include "ofxImageSequenceVideoUringReader.h"
+#include "ofxImageSequenceVideoDirectory.h"
+#include "ofxImageSequenceVideoScale.h"
+#include "ofxImageSequenceVideoPixelConvert.h"
 #if defined(USE_TURBO_JPEG) //you can define this in your pre-processor macros to use turbojpeg to speed up jpeg loading 
 	#include "ofxTurboJpeg.h"
 #endif
@@ -19,26 +28,107 @@ class ofxImageSequenceVideo{
 
 public:
 
-	static const int maxFramePingPongDataStructs = 5;
-
 	ofxImageSequenceVideo();
 	~ofxImageSequenceVideo();
 
 	//There are basically 2 operation modes, ASYNC and INMEDIATE. if you specify numThreads = 0,
 	//everything will be in immediate mode. All work will be done in the main thread, blocking on update().
-	//if you specify  numThreads >= 1, threads are spawned to pre-load frames up to the buffer size
-	//you request, so that main thread only loads tex data to GPU (preferred for realtime).
+	//if you specify  numThreads >= 1, a pool of numThreads resident worker threads is created to pre-load
+	//frames up to the buffer size you request, so that main thread only loads tex data to GPU (preferred for realtime).
 	//note that bufferSize is irrelevant in immediate mode.
 	//
 	//useDXTcompression == TRUE >> assumes all your images are in a .dxt format on disk;
-	//look into ofxDXT to see how to compress them
+	//look into ofxDXT to see how to compress them. Pack them into an .isv file (see packImageSequence()) to have
+	//frames uploaded straight from the mapped file, with no per frame copy
     void setup(int numThreads, int bufferSize, bool useDXTcompression, bool _reverse = false);
 	//NOTE - dont change those on the fly, to be setup once before you load the IMG sequence
 
-	//TODO - don't reuse objects, it will probably fail to load a second img sequence so only load once
-	//otherwise things might go wrong
+	//Opt-in - call before setup(). Instead of owning numThreads threads, this player submits its work
+	//to a process-wide pool shared by all players that opt in (one thread per core by default).
+	//The shared pool serves the most urgent frame first (the one needed soonest on screen, across all
+	//players), so the player with the emptiest buffer gets served first. In this mode, numThreads only
+	//caps how many frames this player can have in flight at once.
+	void setUseSharedScheduler(bool shared){ useSharedScheduler = shared; }
+	bool getUseSharedScheduler(){ return useSharedScheduler; }
+	static void setupSharedScheduler(int numThreads); //optional, to be called before any player setup() to override the core count
+	float getSchedulerShare(); //[0..1] fraction of the pool's worker time used by this player
+
+	//Opt-in - call before setup(). Splits each frame load in two stages: numIoThreads threads (owned by this player)
+	//read the frame's encoded bytes into RAM, and the decode threads (numThreads from setup(), or the shared scheduler)
+	//decode them. This way a thread waiting on the disk is not a core that could be decoding, and the disk queue
+	//doesn't go idle while all threads decode. maxQueuedDecodes bounds how many frames can be read and waiting to be
+	//decoded; when full, the I/O threads wait for the decoders to catch up. DXT frames are read and decompressed in
+	//one go by ofxDXT, so they are fully loaded in the I/O stage. numIoThreads = 0 disables the pipeline (default).
+	void setPipelineThreads(int numIoThreads, int maxQueuedDecodes = 4);
+	int getNumIoThreads(){ return numIoThreads; }
+
+	//Opt-in, Linux only - call before setup(). The I/O stage of the pipeline (see above) is done by an io_uring reader
+	//instead of I/O threads: the reads of all the frames spawned in an update() go to the kernel as one batch, with no
+	//per-file open/read/close syscalls. directIO opens files with O_DIRECT, bypassing the page cache; for sequences far
+	//larger than RAM. Needs USE_IO_URING defined (and linking with -luring), falls back to setPipelineThreads() I/O
+	//threads (or to regular loading) if io_uring is not available. Not for DXT sequences (ofxDXT only loads from disk).
+	void setUseIoUring(bool use, bool directIO = false);
+	bool isUsingIoUring(){ return uringReader != nullptr; }
+
+	//path can be a directory full of images, or a packed .isv file (see packImageSequence())
+	//Can be called at any time (ie during playback) and as often as needed; frames still being loaded for the previous
+	//sequence are dropped, and its memory is freed as soon as the last of them is done.
 	bool loadImageSequence(const std::string & path, float frameRate);
 
+	//pattern based sequences: pattern is a printf style path with a single integer field (ie "shot_%06d.jpg"), and frames
+	//firstFrame..lastFrame (both included) make the sequence. There's no directory listing and no per-frame path strings;
+	//paths are generated when a frame is read, so loading is O(1) in time and memory no matter the sequence length.
+	//Missing (or unreadable) frames are found as they get loaded; the previous frame stays on screen in their place.
+	bool loadImageSequence(const std::string & pattern, int firstFrame, int lastFrame, float frameRate);
+	int getNumMissingFrames(){ return numMissingFrames; } //found so far
+
+	//chunked sequences: the images in all these directories, in this order, play as a single sequence. There's one
+	//buffer window over the whole timeline, so frames are prefetched across chunk boundaries like any other frames.
+	//Directories without images are skipped. getMoviePath() returns the 1st directory.
+	bool loadImageSequence(const vector<std::string> & directories, float frameRate);
+	bool loadImageSequence(std::initializer_list<std::string> directories, float frameRate){ //{"reel/0000", "reel/0001"}
+		return loadImageSequence(vector<std::string>(directories), frameRate);
+	}
+	//subdirectories of path (not path itself), in natural order. ie for "reel/0000/", "reel/0001/"...:
+	//loadImageSequence(ofxImageSequenceVideo::getSubdirectories("reel"), fps);
+	//recursive: each subdirectory is followed by its own subdirectories (depth first)
+	static vector<std::string> getSubdirectories(const std::string & path, bool recursive = false);
+
+	//Gapless playback - queues a sequence to be played right after the current one. While the current one plays, the
+	//first frames of the queued one are decoded in the background (see setPrerollFrames()), and when playback goes past
+	//the current sequence's end (where it would loop or stop) it switches to the queued one, carrying over the time into
+	//the frame; no cold start, no stall. When bouncing (reverse), the end is when it gets back to where it started.
+	//eventSequenceChanged is notified on the switch. Only one sequence can be queued; queueing another replaces it.
+	//Returns false if the sequence can't be opened (and nothing is queued).
+	bool queueNextSequence(const std::string & path, float frameRate);
+	bool queueNextSequence(const std::string & pattern, int firstFrame, int lastFrame, float frameRate);
+	bool queueNextSequence(const vector<std::string> & directories, float frameRate);
+	bool queueNextSequence(std::initializer_list<std::string> directories, float frameRate){
+		return queueNextSequence(vector<std::string>(directories), frameRate);
+	}
+	bool hasQueuedSequence(){ return nextSequence != nullptr; }
+	void clearQueuedSequence(); //the current sequence will loop / stop at its end as usual
+	//how many frames of the queued sequence to have decoded ahead of the switch (async mode only). They are loaded with
+	//the threads the current sequence's buffer doesn't need, after it in priority, and take RAM on top of the buffer.
+	//0 (default): the buffer window just carries on into the queued sequence once the current one's end is in it
+	void setPrerollFrames(int numFrames){ numPrerollFrames = MAX(0, numFrames); }
+	int getNumPrerolledFrames(); //frames of the queued sequence that are already decoded
+
+	//Plays a list of directories / .isv files back to back, gaplessly (see queueNextSequence()). Loads the 1st one and
+	//queues the next one after each switch. If loop is FALSE, the last item loops / stops depending on setLoop().
+	bool setPlaylist(const vector<std::string> & paths, float frameRate, bool loop);
+	int getPlaylistIndex(){ return playlist.size() ? playlistIndex : -1; } //item being played, -1 if not playing a playlist
+
+	//transition stats - a stall is a switch to a queued sequence whose 1st frame wasn't decoded in time (async mode only)
+	int getNumTransitions(){ return numTransitions; }
+	int getNumTransitionStalls(){ return numTransitionStalls; }
+	float getLastTransitionStallTime(){ return lastTransitionStallTime; } //seconds the last stalled switch waited
+
+	//packs all images in a directory into a single .isv file - one file to open, frames are read at known
+	//offsets, and no per-frame file open / directory scan at load time. If there are no images, it packs the
+	//directory's .dxt files (bare compressed blocks, to be played with useDXTcompression)
+	static bool packImageSequence(const std::string & dirPath, const std::string & isvPath);
+
 	//if TRUE, it effectivelly loads the whole img sequence into GPU (during the 1st playback)
 	//during the first playback pass, all frames will be loaded from disk, but on the following
 	//passes, no more loading will happen as the ofTextures already will be in the GPU.
@@ -48,7 +138,79 @@ public:
 	void setKeepTexturesInGpuMem(bool keep){keepTexturesInGpuMem = keep; }
 	bool getKeepTexturesInGpuMem(){return keepTexturesInGpuMem;}
 
-	//this call is a bit expensive as we need to walk all the textures, use sparsingly or for debug only.
+	//Memory budgets in bytes, an alternative to hand tuning bufferSize and setKeepTexturesInGpuMem() per sequence.
+	//ramBytes: all the RAM the player holds frames in (see getRamUse()). Once the 1st frame is decoded and its size is
+	//known, the buffer is sized to as many frames as fit (overriding the bufferSize given in setup()) in what's left
+	//once the other users are accounted for: the spare decode buffers (numThreads + 2 frames), the queued sequence's
+	//preroll frames (see setPrerollFrames()) and the encoded RAM tier (as it fills up, the buffer shrinks).
+	//vramBytes: textures of already shown frames are kept in the GPU (as in setKeepTexturesInGpuMem(true)) as long
+	//as they fit; when over budget, the ones that will be needed last (furthest from the playhead) are dropped.
+	//0 means no budget for that tier (default).
+	void setMemoryBudget(size_t ramBytes, size_t vramBytes);
+	size_t getRamUse(); //bytes currently held in decoded frames (both sequences'), spare decode buffers and the encoded RAM tier
+	size_t getVramUse(); 							//bytes currently held in kept textures
+
+	//Encoded RAM tier: keeps the raw file bytes (jpg, png...) of each frame in RAM after it's first read from disk,
+	//up to maxBytes. Later passes (ie looping) decode from memory and don't touch the disk at all. Encoded frames are
+	//a fraction of the decoded size, so short sequences usually fit whole. Once full, frames that don't fit keep
+	//being read from disk. Not available for DXT sequences (ofxDXT only loads from disk) nor for .isv files (those
+	//are memory mapped, the OS page cache already plays this role). 0 to disable (default). Call before loading.
+	void setEncodedCacheBudget(size_t maxBytes){ encodedCacheBudget = maxBytes; }
+	size_t getEncodedCacheUse(); //current and queued sequences
+	float getEncodedCacheHitRate(); //[0..1] fraction of frame loads served from the encoded RAM tier, since the current sequence was loaded
+
+	//Reduced resolution decoding, for sequences drawn smaller than their native size (ie tiles in a grid). Frames are
+	//decoded at the smallest of 1/1, 1/2, 1/4 or 1/8 of their size that still covers width x height (so they don't look
+	//soft when drawn at that size); RAM, VRAM and texture uploads shrink with them. With USE_TURBO_JPEG, jpgs are scaled
+	//while decoding (libjpeg-turbo DCT scaling, cheaper than a full decode), other formats are box filtered after being
+	//decoded, in the worker threads. Aspect ratio is kept; 0 leaves a dimension unconstrained, and 0, 0 decodes at full
+	//size (default). Not available for DXT sequences. Call before loading.
+	void setTargetResolution(int width, int height){ targetWidth = MAX(0, width); targetHeight = MAX(0, height); }
+
+	//Pixel format of the decoded frames handed to the main thread. Frames are converted in the worker threads, so that
+	//texture uploads get them in the layout the driver wants (ie BGRA on many desktop GPUs) instead of the driver
+	//converting them on the main thread. Converts RGB -> RGBA / BGRA, RGBA -> BGRA, and RGBA -> RGB (for sequences saved
+	//with an opaque alpha channel); frames in other formats are left as they are. With USE_TURBO_JPEG, jpgs are decoded
+	//straight into RGBA / BGRA. OF_PIXELS_UNKNOWN keeps what the decoder outputs (default). Not for DXT. Call before loading.
+	void setOutputPixelFormat(ofPixelFormat format){ outputPixelFormat = format; }
+	ofPixelFormat getOutputPixelFormat(){ return outputPixelFormat; }
+
+	//Which library decodes the frames (in the worker threads):
+	//AUTO: TURBOJPEG if built with USE_TURBO_JPEG, FREEIMAGE otherwise (default)
+	//FREEIMAGE: ofLoadImage() for everything
+	//TURBOJPEG: libjpeg-turbo for jpgs (needs USE_TURBO_JPEG), FreeImage for the rest
+	//STB: stb_image (lib/stb) for jpg, png, tga & bmp, FreeImage for the rest. No conversion layers, usually faster than
+	//FreeImage for png; it doesn't scale jpgs while decoding as turbojpeg does (they are scaled after, see setTargetResolution())
+	//Which one is fastest depends on the format and the images, see "isvBench decode" in tools/isvBench. Call before loading.
+	enum class Decoder : uint8_t{
+		AUTO,
+		FREEIMAGE,
+		TURBOJPEG,
+		STB
+	};
+	void setDecoder(Decoder d){ decoder = d; }
+	Decoder getDecoder(){ return decoder; }
+	Decoder getDecoderFor(const string & fileExt); //the one that will actually decode files of that type
+	static string getDecoderName(Decoder decoder);
+
+	//decodes one frame's encoded bytes (ie a jpg file in memory) as the worker threads would, with this player's decoder,
+	//target resolution and output pixel format. Thread safe. For benchmarks and tools, see tools/isvBench
+	bool decodeImage(const string & fileExt, const unsigned char * data, size_t size, ofPixels & pixels){
+		return decodeFromMemory(fileExt, data, size, pixels);
+	}
+
+	//Kernel readahead hints, for cold cache playback from spinning disks or network mounts. The player tells the OS which
+	//files it will need next: frames up to distance (presented) frames past the buffer window get a WILLNEED hint, so
+	//the kernel starts reading them in the background. With dropDisplayedFrames, frames that have been shown and won't
+	//be back within that horizon get a DONTNEED, so a long sequence doesn't push everything else out of the page cache.
+	//distance = 0 disables it (default). Async mode only.
+	void setReadaheadHints(int distance, bool dropDisplayedFrames = false);
+	//[0..1] fraction of the current sequence's frame reads that found the whole frame in the page cache; only measured
+	//with readahead hints on. The reads themselves find out (non blocking reads first, Linux only), so it costs nothing
+	//on a hit. Reads from the encoded RAM tier, through io_uring, of DXT frames and of mapped .isv files that the process
+	//can't write are not counted.
+	float getPageCacheHitRate();
+
 	bool areAllTexturesPreloaded(); //(in In Gpu Mem), only makes sense when setKeepTexturesInGpuMem(TRUE);
 
 	//set to FALSE for it to avoid GL calls - only ofPixels will be loaded (handy to use it from a thread)
@@ -78,7 +240,7 @@ public:
     
     bool isPlaying(); 
 
-	void setPlaybackSpeed(float speed){playbackSpeed = speed;}; //1.0 means normal speed. don't go negative or weird things will happen!
+	void setPlaybackSpeed(float speed); //1.0 means normal speed. negative values play backwards
 	float getPlaybackSpeed(){return playbackSpeed;}
 
 	void advanceOneFrame();
@@ -114,9 +276,14 @@ public:
 	std::string getStatus();
 	std::string getBufferStatus(int extendBeyondBuffer = 0);
 	std::string getGpuBufferStatus(int extendBeyondBuffer = 0);
-	std::string getNumTasks(){ return ofToString(tasks.size()) + "/" + ofToString(numThreads); }
+	std::string getNumTasks(){ return ofToString(numTasksInFlight) + "/" + ofToString(numThreads); }
 	float getBufferFullness(){ return bufferFullness;}
 	float getLoadTimeAvg(){ return loadTimeAvg; } //avg time to load a single frame from disk to pixels, in ms
+	//load time split in its I/O and decode parts, in ms (async mode). With the pipeline (see setPipelineThreads()), if
+	//read time dominates, add I/O threads; if decode time does (and the queue wait grows), add decode threads.
+	float getReadTimeAvg(){ return readTimeAvg; } 		//time to get a frame's encoded bytes in RAM
+	float getDecodeTimeAvg(){ return decodeTimeAvg; } 	//time to decode a frame into pixels
+	float getQueueWaitAvg(){ return queueWaitAvg; } 	//pipeline only, time a read frame waits to start decoding
 
 	struct EventInfo{
 		ofxImageSequenceVideo * who = nullptr;
@@ -124,41 +291,98 @@ public:
 
 	ofFastEvent<EventInfo> eventMovieLooped;
 	ofFastEvent<EventInfo> eventMovieEnded;
+	ofFastEvent<EventInfo> eventSequenceChanged; //switched to the queued sequence, see queueNextSequence()
 
-	//get a sorted list of all imgs in a dir
+	//get a sorted list of all imgs in a dir (natural order, so that frame_10 comes after frame_9)
 	static vector<string> getImagesAtDirectory(const string & path, bool useDxtCompression);
 
+	//Opt-in, for huge directories / network drives: getImagesAtDirectory() saves each directory listing to a manifest
+	//file, and following loads of the same directory read it instead of scanning it again (as long as the directory's
+	//modification time hasn't changed). Manifests are hidden files next to the directory (".<dirName>.isvManifest"),
+	//or in cacheDir if provided (for read only media).
+	static void setUseDirectoryManifests(bool use, const string & cacheDir = "");
+
 	static char asciitolower(char in);
 
 protected:
 
+	static bool useDirectoryManifests;
+	static string directoryManifestsDir;
+
 	static vector<string> getSupportedImageTypes(){ return{"tga", "gif", "jpeg", "jpg", "jp2", "bmp", "png", "tif", "tiff"};}
 
-	enum class PixelState{
+	//Frame pixel state machine. Transitions are atomic, ownership of the frame's pixel data follows the state:
+	// NOT_LOADED -> LOADING 					main thread, on spawn. From now on, the worker owns the pixel data
+	// LOADING -> THREAD_FINISHED_LOADING 		worker, release; publishes the pixel data back to the main thread
+	// LOADING -> FAILED 						worker, release; the file is missing or can't be decoded, nothing to show
+	// LOADING -> DISREGARDED 					main thread, when a frame being loaded falls out of the buffer
+	// THREAD_FINISHED_LOADING -> LOADED 		main thread, once uploaded to GPU
+	// DISREGARDED / LOADED / THREAD_FINISHED_LOADING / FAILED -> NOT_LOADED		main thread, pixel data freed
+	//Only the main thread frees pixel data, and only when it owns it.
+	enum class PixelState : uint8_t{
 		NOT_LOADED,
 		LOADING,
 		THREAD_FINISHED_LOADING,
-		LOADED
+		LOADED,
+		DISREGARDED, //still loading, but it's results will be dropped when the worker is done
+		FAILED //loaded, but there's nothing to show; flagged MISSING when the main thread gets the results
 	};
 
-	enum class TextureState{
+	enum class TextureState : uint8_t{
 		NOT_LOADED,
 		LOADED
 	};
 
-	struct FrameInfo{
-		string filePath;
+	//the heavy part of a frame. Only resident frames have one (pixels loading / loaded, a kept texture or encoded bytes)
+	struct FrameData{
 		ofPixels pixels;
 		ofxDXT::Data compressedPixels;
-		PixelState pixState = PixelState::NOT_LOADED;
-		float loadTime = 0; //ms
-		bool shouldDisregardWhenLoaded = false;
-
-		TextureState texState = TextureState::NOT_LOADED;
+		ofxImageSequenceVideoDXTView compressedView; //instead of compressedPixels, for .isv files
+		ofBuffer encodedBytes; //raw file contents, only when the encoded RAM tier is on. Owned by whoever owns the frame (see PixelState)
 		ofTexture texture; 	//only to be kept around when we are trying to
 							//cache the whole anim (bufferSize == numFrames)
 	};
 
+	//Structure of arrays frame table. The per-frame state walked every update() lives in packed arrays (a few bytes per
+	//frame), and FrameData is only allocated for resident frames; it's recycled through a free list, so in steady state
+	//playback doesn't allocate any. Directory sequences keep their file names back to back in a single string.
+	//There's one per loaded sequence; tasks hold a shared_ptr to the table they work on, see frameTable.
+	struct FrameTable{
+		enum Flags : uint8_t{
+			MISSING = 1, 			//missing or unreadable, found at load time
+			PAGE_CACHE_HINTED = 2, 	//WILLNEED already sent, not loaded since
+			ENCODED = 4 			//its encoded bytes are in the encoded RAM tier
+		};
+
+		int numFrames = 0;
+		uint32_t generation = 0; //which loadImageSequence() / queueNextSequence() call this table belongs to
+		string fileExtension; //lowercase; jpg, tiff, dxt, etc. Workers pick the decoder by it
+		std::unique_ptr<std::atomic<PixelState>[]> pixState;
+		vector<TextureState> texState;
+		vector<uint8_t> flags; //main thread only
+		vector<FrameData*> data; //null for frames that hold nothing. Set by the main thread, while it owns the frame
+
+		vector<string> pathPrefixes; //directory sequences only - "dir/", one per directory (chunk) the sequence spans
+		vector<int> prefixFirstFrames; //1st frame of each chunk
+		string names; //all file names, back to back
+		vector<uint32_t> nameOffsets; //numFrames + 1 entries, name i is [nameOffsets[i], nameOffsets[i+1])
+
+		//memory accounting lives with the table, so that tasks finishing late for an old sequence don't skew the new one's
+		std::atomic<int64_t> ramBytesInUse{0}; //decoded frames
+		std::atomic<size_t> encodedCacheBytes{0}; //encoded RAM tier
+
+		void setup(int num); //tables are not reused, each sequence gets a new one
+		void addPaths(const string & dir, const vector<string> & fileNames); //appends a directory's frames to the timeline
+		bool hasFlag(int frame, uint8_t flag) const { return flags[frame] & flag; }
+		void setFlag(int frame, uint8_t flag, bool set){ if(set) flags[frame] |= flag; else flags[frame] &= ~flag; }
+		FrameData & acquireData(int frame); //main thread; the frame's FrameData, allocated (or recycled) if it has none
+		void releaseData(int frame); //main thread; back to the free list if the frame doesn't hold anything anymore
+
+	protected:
+		vector<std::unique_ptr<FrameData>> dataSlots; //all FrameData allocated so far, in use or free
+		vector<FrameData*> freeData;
+	};
+
 	bool loaded = false;
 	string imgSequencePath;
 	bool keepTexturesInGpuMem = false;
@@ -186,39 +410,239 @@ protected:
 	float playbackSpeed = 1.0;
 	bool shouldLoop = true;
 
-	vector<FrameInfo> frames[maxFramePingPongDataStructs];
-	int currentFrameSet = -1;
-	//this weird thing is to make the "frames" structure ping-poing so that when we load a new
-	//video, we can safely move to a new struct and leave the running threads do its thing on the
-	//old struct, without having to worry about destroying the memory they are working on
-	//TODO - sloppy and wasteful!
+	//Each loadImageSequence() gets a fresh table, tagged with a new generation. Tasks hold a shared_ptr to the table they
+	//were spawned for, so an old table stays alive (and safe to write into) until its last task is done, and is freed
+	//right then. Tasks check their table's generation before doing any work, and update() drops the results of old
+	//generations; so reloading mid playback costs no more than the tasks that were already running.
+	//The queued sequence (see queueNextSequence()) has its own table and generation, live while it's queued.
+	std::shared_ptr<FrameTable> frameTable;
+	uint32_t lastGeneration = 0; //main thread, to tag new tables
+	std::atomic<uint32_t> generation{0}; //the current sequence's
+	std::atomic<uint32_t> prerollGeneration{0}; //the queued sequence's, 0 if none
+	bool isStale(const FrameTable & table){ //thread safe
+		return table.generation != generation.load(std::memory_order_relaxed) &&
+			   table.generation != prerollGeneration.load(std::memory_order_relaxed);
+	}
 
 	ofTexture tex;
 	ofPixels currentPixels; //used in immediate mode only (numThreads==0)
 	ofxDXT::Data currentPixelsCompressed; //same as above, but with DXT compression
+	ofxImageSequenceVideoDXTView currentCompressedView; //same as above, for DXT .isv files
 	bool shouldLoadTexture = true; //use setUseTexture() to disable texture load (and GL calls) alltogether
 									//this allows using this class from non-main thread
 
 	struct LoadResults{
-		int frame;
-		float elapsedTime;
-		float filesizeKb;
+		int frame = -1;
+		float elapsedTime = 0;
+		float filesizeKb = 0;
 		bool shouldBeDisregaded = false;
+		float readTime = 0; //ms, to get the encoded bytes into RAM (DXT: the whole load)
+		float decodeTime = 0;
+		float queueWaitTime = 0; //pipeline only (see setPipelineThreads())
+		int pageCacheHit = -1; //1 if the frame was in the page cache when the worker went to read it, -1 if unknown
+		bool loadOK = true; //false if the file is missing or can't be read / decoded
+		uint32_t generation = 0; //of the frame table the frame was loaded for
 	};
 
-	float loadTimeAvg = 0.0f;
+	struct FramePattern{ //for pattern based sequences; immutable, workers hold on to it while they run
+		string pattern; //printf style, absolute
+		int firstFrame = 0;
+	};
+
+	//what a loadImageSequence() call opens; made current right away, or kept as the queued sequence
+	struct Sequence{
+		std::shared_ptr<FrameTable> table;
+		std::shared_ptr<ofxImageSequenceVideoPackedFile> packed; //only for .isv files
+		std::shared_ptr<const FramePattern> pattern; //only for pattern based sequences
+		string path;
+		float frameRate = 0.0f;
+	};
+	bool openSequence(const string & path, float frameRate, Sequence & seq); //lists the dir / opens the .isv, new frame table
+	bool openSequence(const string & pattern, int firstFrame, int lastFrame, float frameRate, Sequence & seq);
+	bool openSequence(const vector<string> & directories, float frameRate, Sequence & seq);
+	void setupFrames(Sequence & seq, bool gapless); //makes seq the current sequence; gapless keeps the playhead's timing and texture
+	void startLoading(); //after setupFrames()
+
+	//gapless playback - see queueNextSequence()
+	std::unique_ptr<Sequence> nextSequence;
+	int numPrerollFrames = 0;
+	void setQueuedSequence(std::unique_ptr<Sequence> seq);
+	bool isAtSequenceEnd(int frame, int direction); //frame is out of range, past where the current sequence hands over to the queued one
+	void switchToNextSequence(bool triggerEvents);
+	void getPrerollFrames(vector<int> & frames); //the queued sequence's 1st frames, in the order they'll be shown
+	void handlePrerollResults(LoadResults & results);
+	vector<string> playlist;
+	int playlistIndex = 0;
+	bool loopPlaylist = false;
+	float playlistFrameRate = 0.0f;
+	bool playlistNeedsQueue = false; //queue the next item at the end of this update(), not mid playhead advance
+	void queueNextPlaylistItem();
+	int numTransitions = 0;
+	int numTransitionStalls = 0;
+	float lastTransitionStallTime = 0.0f;
+	bool transitionPending = false; //switched, the new sequence's 1st frame is not on screen yet
+	float transitionWaitTime = 0.0f;
 
-	vector<std::future<LoadResults>> tasks; //store thread futures
+	float loadTimeAvg = 0.0f;
+	float readTimeAvg = 0.0f;
+	float decodeTimeAvg = 0.0f;
+	float queueWaitAvg = 0.0f;
+
+	int numTasksInFlight = 0; //submitted to the pool, results not yet collected by handleThreadCleanup()
+	ofxImageSequenceVideoMPSCQueue<LoadResults> completedTasks; //workers push results here, update() drains it
+	std::shared_ptr<ofxImageSequenceVideoThreadPool> threadPool; //resident worker threads, created on setup() (or shared)
+	int threadPoolClientID = -1;
+	bool useSharedScheduler = false;
+	void releaseThreadPool();
+
+	//two stage pipeline - see setPipelineThreads()
+	struct PipelineJob{ //a frame on its way through the I/O and decode stages
+		std::shared_ptr<FrameTable> table;
+		int frameIndex = -1;
+		std::shared_ptr<ofxImageSequenceVideoPackedFile> packed;
+		std::shared_ptr<const FramePattern> pattern;
+		ofBuffer buffer; //the encoded bytes, unless they live in the packed file mapping or the encoded RAM tier
+		const unsigned char * data = nullptr;
+		size_t size = 0;
+		bool readOK = false;
+		double dueTime = 0; //when the frame is due on screen, on ofxImageSequenceVideoThreadPool::now()'s clock
+		uint64_t readEndTime = 0;
+		std::shared_ptr<unsigned char> alignedBuffer; //when read by the io_uring reader
+		LoadResults results;
+	};
+	int numIoThreads = 0;
+	int maxQueuedDecodes = 4;
+	std::shared_ptr<ofxImageSequenceVideoThreadPool> ioPool; //always owned by the player
+	int ioPoolClientID = -1;
+	std::mutex pipelineMutex;
+	std::condition_variable pipelineCondition; //signaled when a decode starts (frees a slot in the bounded queue)
+	int numQueuedDecodes = 0; //read, waiting for a decode thread
+	bool pipelineShuttingDown = false;
+	void submitPipelinedLoad(const Sequence & seq, int frameIndex, double deadline);
+	void readStage(std::shared_ptr<PipelineJob> job);
+	void decodeStage(std::shared_ptr<PipelineJob> job);
+	void queueDecode(std::shared_ptr<PipelineJob> job, bool waitForSlot); //hands a read frame over to the decode stage
+
+	bool useIoUring = false;
+	bool ioUringDirectIO = false;
+	std::unique_ptr<ofxImageSequenceVideoUringReader> uringReader;
+	void submitUringLoad(const Sequence & seq, int frameIndex, double deadline,
+						 std::vector<std::unique_ptr<ofxImageSequenceVideoUringReader::Request>> & requests);
+	//hands a frame of seq (NOT_LOADED) over to the workers, by whichever path this player loads frames through
+	void spawnLoad(const Sequence & seq, int frame, double deadline,
+				   std::vector<std::unique_ptr<ofxImageSequenceVideoUringReader::Request>> & uringRequests);
 
 	int numBufferFrames = 8;
+	int getBufferLength(); //numBufferFrames, or what fits in the RAM budget
+
+	size_t ramBudget = 0;
+	size_t vramBudget = 0;
+	size_t decodedFrameBytes = 0; //learnt from the 1st decoded frame
+	int lastBufferLength = 0; //with a RAM budget the buffer can shrink during playback, see update()
+	size_t textureBytes = 0; //learnt from the 1st kept texture
+
+	size_t encodedCacheBudget = 0;
+	std::atomic<uint64_t> encodedCacheHits{0};
+	std::atomic<uint64_t> encodedCacheMisses{0};
+	std::set<int> residentTextures; //frames with a kept texture
+	bool shouldKeepTextures(){ return keepTexturesInGpuMem || vramBudget > 0; }
+	void trimTextureCache(); //drop kept textures that are furthest from the playhead until we are within budget
+	static size_t getFrameBytes(FrameData & frame);
+	//uploads a DXT frame, from the view if it's set or from data otherwise
+	static void loadDXTIntoTexture(ofxDXT::Data & data, const ofxImageSequenceVideoDXTView & view, ofTexture & texture);
 	int numThreads = 3;
 
 	bool useDXTCompression = false;
-	string fileExtension; //jpg, tiff, dxt, etc
-
-	ofxImageSequenceVideo::LoadResults loadFrameThread(int frame);
+	string fileExtension; //jpg, tiff, dxt, etc - of the current sequence
+
+	ofxImageSequenceVideo::LoadResults loadFrameThread(FrameTable & table, int frame, ofxImageSequenceVideoPackedFile * packed,
+													   const FramePattern * pattern);
+
+	std::shared_ptr<const FramePattern> framePattern; //null for directories / .isv files
+	//the path of a frame - thread safe. Paths are built into a thread local buffer, so the returned string is only valid
+	//until the next call on the same thread. Empty for .isv files
+	static const string & getFramePath(const FramePattern * pattern, const FrameTable & table, int frameIndex);
+	static bool isValidFramePattern(const string & pattern); //exactly one integer field (%d, %06d, %.6d, %i, %u...), %% allowed
+	int numMissingFrames = 0;
+	bool isFrameMissing(int frame){ return frameTable->hasFlag(frame, FrameTable::MISSING); }
+	void handleMissingFrame(int frame);
+	//worker side end of a frame load: accounts for the frame's memory and hands its pixels to the main thread
+	void publishFrame(FrameTable & table, int frame, const unsigned char * prevPixelBuffer, LoadResults & results);
+
+	//loads a frame from disk (or from the packed file if not null) into pixels, compressedPixels or compressedView -
+	//thread safe. Encoded bytes are read into a per thread buffer with readFrameBytes(), and decoded from memory; DXT
+	//frames are loaded by ofxDXT, or pointed at in the mapped packed file (compressedView, see ofxImageSequenceVideoDXTView).
+	//if encodedCache is provided, the frame's encoded bytes are decoded from / kept in there (see
+	//setEncodedCacheBudget()), and accounted for in encodedCacheBytes. Fills the file size and timings in results if given
+	bool loadFrameData(ofxImageSequenceVideoPackedFile * packed, int frame, const string & filePath, const string & fileExt,
+					   ofPixels & pixels, ofxDXT::Data & compressedPixels, ofxImageSequenceVideoDXTView & compressedView,
+					   LoadResults * results = nullptr, ofBuffer * encodedCache = nullptr, std::atomic<size_t> * encodedCacheBytes = nullptr);
+	bool decodeFromMemory(const string & fileExt, const unsigned char * data, size_t size, ofPixels & pixels);
+	Decoder decoder = Decoder::AUTO;
+	bool decodeTurboJpeg(const unsigned char * data, size_t size, ofPixels & pixels);
+	bool decodeStb(const unsigned char * data, size_t size, ofPixels & pixels);
+
+	//reduced resolution decoding - see setTargetResolution()
+	int targetWidth = 0;
+	int targetHeight = 0;
+	bool isDecodingToTarget(){ return targetWidth > 0 || targetHeight > 0; }
+	ofPixelFormat outputPixelFormat = OF_PIXELS_UNKNOWN; //see setOutputPixelFormat()
+
+	//post decode stage, in the worker: scales (see setTargetResolution()) and converts (see setOutputPixelFormat()) the
+	//decoded frame into pixels, or hands it over as is if there's nothing to do. Decoders that can't scale / convert as
+	//they decode write into getDecodeBuffer(): a per thread buffer if there's a post decode stage, pixels otherwise
+	ofPixels & getDecodeBuffer(ofPixels & pixels);
+	bool finishFrame(ofPixels & decoded, ofPixels & pixels);
+	bool needsPostDecodeStage(int width, int height, ofPixelFormat format); //for a decoded frame of that size & format
+
+	//I/O half of loadFrameData(): gets the frame's encoded bytes into RAM - thread safe. On success, data & size point to
+	//them; either in the packed file mapping, in encodedCache (if provided and the encoded RAM tier is on) or in buffer.
+	//prefault: when reading from a mapped packed file, touch its pages now so that page faults don't hit the decoder
+	//pageCacheHit: if given, set to whether the read found the frame in the page cache (see LoadResults::pageCacheHit)
+	bool readFrameBytes(ofxImageSequenceVideoPackedFile * packed, int frame, const string & filePath, ofBuffer & buffer,
+						ofBuffer * encodedCache, std::atomic<size_t> * encodedCacheBytes, const unsigned char *& data,
+						size_t & size, bool prefault, int * pageCacheHit = nullptr);
+
+	std::shared_ptr<ofxImageSequenceVideoPackedFile> packedFile; //only when playing an .isv file
+
+	ofxImageSequenceVideoPixelPool pixelPool; //decoded frame buffers are recycled through here
+	bool pixelPoolPrefilled = false;
+	void releasePixels(int frame){ releasePixels(*frameTable, frame); }
+	void releasePixels(FrameTable & table, int frame); //frees the frame's pixel data (recycling the buffer if possible), back to NOT_LOADED
 
 	void eraseOutOfBufferPixelCache();
+	void erasePixelCache(int frame); //frees the frame pixels, or flags them as disregarded if a thread is loading them
+
+	//The buffer window holds the next numBufferFrames frames that will be shown, in the order they will be shown.
+	//It follows the playback direction (reverse playback, bouncing, negative speeds) and wraps / clamps at the ends
+	//as playback will. Prefetch walks it in order, and everything outside of it can be evicted.
+	//When playing fast enough to skip frames (speed > 1, not holding playback), only the frames that will actually
+	//be presented are in the window, so the buffer is measured in presented frames and skipped ones are never loaded.
+	vector<int> bufferWindow;
+	vector<float> bufferWindowTimes; //seconds until each frame in the window is due on screen
+	float updateDtAvg = 0.0f; //to predict how many frames each update() will advance; smoothed, so that a single
+							  //hitch (or vsync jitter) doesn't change the predicted frames and drop freshly decoded ones
+	vector<uint32_t> bufferWindowStamps; //one per frame; frame is in the window if its stamp == bufferWindowStamp
+	uint32_t bufferWindowStamp = 0;
+	void updateBufferWindow(); //call whenever currentFrame or the playback direction changes
+	void getUpcomingFrames(int numUpcomingFrames, vector<int> & upcomingFrames, vector<float> * timesUntilShown = nullptr); //simulates playback from currentFrame
+	int stepFrame(int frame, int & direction); //where playback goes after frame, might flip direction when bouncing. -1 if the queued sequence takes over
+	bool isFrameInBuffer(int frame){ return bufferWindowStamps[frame] == bufferWindowStamp; }
+	int getPlaybackDirection(); //+1 forward, -1 backwards
+
+	//readahead hints - see setReadaheadHints()
+	std::atomic<int> readaheadDistance{0}; //set from the main thread at any time; workers read it to decide whether to probe
+	bool dropDisplayedFrames = false;
+	vector<int> readaheadWindow; //the frames after the buffer window, up to readaheadDistance, in playback order
+	vector<uint32_t> readaheadWindowStamps; //same scheme as bufferWindowStamps
+	int lastDisplayedFrame = -1;
+	int pageCacheHits = 0;
+	int pageCacheProbes = 0;
+	void handleReadaheadHints();
+	//worker side; where the read should report if it hit the page cache, null if we are not measuring it
+	int * getPageCacheProbe(LoadResults * results){
+		return results && readaheadDistance.load(std::memory_order_relaxed) > 0 ? &results->pageCacheHit : nullptr;
+	}
 
 	float bufferFullness = 0.0f; //just to smooth out buffer len 
 
@@ -0,0 +1,47 @@
+//
+//  ofxImageSequenceVideoDXTView.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoDXTView.h"
+#include "ofxDXT.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT		0x83F0
+	#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT	0x83F2
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT	0x83F3
+#endif
+
+
+size_t ofxImageSequenceVideoDXTView::getSize(int width, int height, int compressionType){
+	size_t numBlocks = (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4);
+	return numBlocks * (compressionType == ofxDXT::DXT1 ? 8 : 16);
+}
+
+
+void ofxImageSequenceVideoDXTView::loadIntoTexture(ofTexture & tex) const{
+
+	if(!isSet()) return;
+	GLint glFormat = compressionType == ofxDXT::DXT1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT :
+					 compressionType == ofxDXT::DXT3 ? GL_COMPRESSED_RGBA_S3TC_DXT3_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	ofTextureData & texData = tex.getTextureData();
+	if(!tex.isAllocated() || texData.width != width || texData.height != height || texData.glInternalFormat != glFormat ||
+	   texData.textureTarget != GL_TEXTURE_2D){
+		ofTextureData newData;
+		newData.width = width;
+		newData.height = height;
+		newData.tex_w = width;
+		newData.tex_h = height;
+		newData.tex_t = 1.0f;
+		newData.tex_u = 1.0f;
+		newData.textureTarget = GL_TEXTURE_2D; //there are no compressed rectangle textures
+		newData.glInternalFormat = glFormat;
+		tex.allocate(newData, GL_RGBA, GL_UNSIGNED_BYTE);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texData.textureID);
+	glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, glFormat, (GLsizei)size, data);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,33 @@
+//
+//  ofxImageSequenceVideoDXTView.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//A DXT frame's compressed blocks, wherever they already are - for DXT frames packed in an .isv file, a view into the
+//file's mapping. ofxDXT::Data always owns its blocks (and ofxDXT only fills it from a file path), so packed DXT frames
+//skip it: workers point a view at the mapped frame, and the main thread uploads straight from there.
+class ofxImageSequenceVideoDXTView{
+
+public:
+
+	const unsigned char * data = nullptr; //not owned; the packed file (or buffer) must outlive the view
+	size_t size = 0;
+	int width = 0;
+	int height = 0;
+	int compressionType = 0; //ofxDXT::DXT1, DXT3 or DXT5
+	ofBuffer buffer; //holds the blocks when the packed file could not be mapped (read with pread()), empty otherwise
+
+	bool isSet() const { return data != nullptr; }
+	void clear(){ data = nullptr; size = 0; buffer.clear(); } //buffer keeps its memory, for the next frame
+
+	//bytes of a width x height frame's blocks (4x4 pixels per block, 8 bytes per DXT1 block, 16 per DXT3 / DXT5)
+	static size_t getSize(int width, int height, int compressionType);
+
+	//uploads the blocks into tex as a compressed GL_TEXTURE_2D, (re)allocating it if its size or format differ.
+	//Does what ofxDXT::loadDataIntoTexture() does for an ofxDXT::Data. Main thread only
+	void loadIntoTexture(ofTexture & tex) const;
+};
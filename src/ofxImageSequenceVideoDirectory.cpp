@@ -0,0 +1,236 @@
+//
+//  ofxImageSequenceVideoDirectory.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoDirectory.h"
+#include <fstream>
+
+#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
+	#include <dirent.h>
+#else
+	#include <dirent_vs.h>
+#endif
+#if defined(__linux__)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/syscall.h>
+#endif
+
+static const char * manifestMagic = "isvManifest 1";
+
+
+//true if name ends in "." + one of the extensions. Doesn't allocate
+static bool hasExtension(const char * name, const vector<string> & extensions){
+	const char * dot = strrchr(name, '.');
+	if(!dot || dot == name) return false;
+	dot++;
+	for(const auto & ext : extensions){
+		if(strcmp(dot, ext.c_str()) == 0) return true;
+	}
+	return false;
+}
+
+
+vector<string> ofxImageSequenceVideoDirectory::scan(const string & dirPath, const vector<string> & extensions){
+
+	vector<string> fileNames;
+
+	#if defined(__linux__)
+	int fd = ::open(dirPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0) return fileNames;
+
+	struct LinuxDirent64{ //as returned by getdents64(), d_name is null terminated
+		uint64_t d_ino;
+		int64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[1];
+	};
+
+	std::vector<char> buffer(256 * 1024); //big reads, fewer round trips on network file systems
+	while(true){
+		long numBytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+		if(numBytes <= 0) break;
+		for(long pos = 0; pos < numBytes;){
+			const LinuxDirent64 * ent = (const LinuxDirent64 *)(buffer.data() + pos);
+			pos += ent->d_reclen;
+			if(ent->d_name[0] == '.') continue; //hidden
+			if(ent->d_type != DT_REG && ent->d_type != DT_LNK && ent->d_type != DT_UNKNOWN) continue; //dirs, fifos...
+			if(!hasExtension(ent->d_name, extensions)) continue;
+			fileNames.emplace_back(ent->d_name);
+		}
+	}
+	::close(fd);
+	#else
+	DIR * dir = opendir(dirPath.c_str());
+	if(!dir) return fileNames;
+	struct dirent * ent;
+	while((ent = readdir(dir)) != NULL){
+		if(ent->d_name[0] == '.') continue;
+		#if defined(DT_DIR)
+		if(ent->d_type == DT_DIR) continue;
+		#endif
+		if(!hasExtension(ent->d_name, extensions)) continue;
+		fileNames.emplace_back(ent->d_name);
+	}
+	closedir(dir);
+	#endif
+
+	naturalSort(fileNames);
+	return fileNames;
+}
+
+
+static inline bool isDigit(char c){
+	return (unsigned char)(c - '0') < 10; //isdigit() is locale aware, and a function call
+}
+
+
+//natural order sort key: runs of digits become a '0' marker, the run length (w/o leading zeros) and the digits. That
+//way, plain byte compares of the keys order numbers by value; and the marker being a digit keeps numbers vs other
+//chars in ascii order
+static void getNaturalSortKey(const string & name, string & key){
+	key.clear();
+	const size_t n = name.size();
+	for(size_t i = 0; i < n;){
+		if(!isDigit(name[i])){
+			key += name[i++];
+			continue;
+		}
+		size_t start = i;
+		while(i < n && isDigit(name[i])) i++;
+		while(start < i - 1 && name[start] == '0') start++; //keep one zero for "0"
+		key += '0';
+		key += (char)MIN(i - start, (size_t)255);
+		key.append(name, start, i - start);
+	}
+}
+
+
+bool ofxImageSequenceVideoDirectory::naturalLess(const string & a, const string & b){
+	string keyA, keyB;
+	getNaturalSortKey(a, keyA);
+	getNaturalSortKey(b, keyB);
+	if(keyA != keyB) return keyA < keyB;
+	return a < b; //same numbers, different leading zeros
+}
+
+
+void ofxImageSequenceVideoDirectory::naturalSort(vector<string> & names){
+	//keys are built once, so the sort itself is plain string compares
+	vector<std::pair<string, uint32_t>> keys(names.size());
+	for(size_t i = 0; i < names.size(); i++){
+		getNaturalSortKey(names[i], keys[i].first);
+		keys[i].second = i;
+	}
+	std::sort(keys.begin(), keys.end(), [&names](const std::pair<string, uint32_t> & a, const std::pair<string, uint32_t> & b){
+		int c = a.first.compare(b.first);
+		if(c != 0) return c < 0;
+		return names[a.second] < names[b.second];
+	});
+	vector<string> sorted;
+	sorted.reserve(names.size());
+	for(auto & k : keys){
+		sorted.emplace_back(std::move(names[k.second]));
+	}
+	names.swap(sorted);
+}
+
+
+vector<string> ofxImageSequenceVideoDirectory::listSubdirectories(const string & dirPath){
+	vector<string> names;
+	std::error_code err;
+	for(std::filesystem::directory_iterator it(dirPath, err), end; !err && it != end; it.increment(err)){
+		string name = it->path().filename().string();
+		if(name.empty() || name[0] == '.') continue; //hidden
+		std::error_code typeErr;
+		if(!it->is_directory(typeErr)) continue;
+		names.emplace_back(std::move(name));
+	}
+	naturalSort(names);
+	return names;
+}
+
+
+string ofxImageSequenceVideoDirectory::getManifestPath(const string & dirPath, const string & cacheDir){
+	std::filesystem::path dir = std::filesystem::path(dirPath).lexically_normal();
+	if(!dir.has_filename()) dir = dir.parent_path(); //trailing slash
+	if(cacheDir.empty()){
+		return (dir.parent_path() / ("." + dir.filename().string() + ".isvManifest")).string();
+	}
+	string name = dir.string(); //flatten the full path into a file name
+	for(auto & c : name){
+		if(c == '/' || c == '\\' || c == ':') c = '_';
+	}
+	return (std::filesystem::path(cacheDir) / (name + ".isvManifest")).string();
+}
+
+
+bool ofxImageSequenceVideoDirectory::readManifest(const string & manifestPath, const string & key, vector<string> & fileNames){
+	std::ifstream in(manifestPath);
+	if(!in) return false;
+	string line;
+	if(!std::getline(in, line) || line != manifestMagic) return false;
+	if(!std::getline(in, line) || line != key) return false; //directory changed since the manifest was written
+	if(!std::getline(in, line)) return false;
+	size_t num = strtoull(line.c_str(), nullptr, 10);
+	fileNames.clear();
+	fileNames.reserve(num);
+	while(std::getline(in, line)){
+		fileNames.emplace_back(std::move(line));
+	}
+	if(fileNames.size() != num){ //truncated
+		fileNames.clear();
+		return false;
+	}
+	return true;
+}
+
+
+void ofxImageSequenceVideoDirectory::writeManifest(const string & manifestPath, const string & key, const vector<string> & fileNames){
+	string tmpPath = manifestPath + ".tmp";
+	{
+		std::ofstream out(tmpPath, std::ios::trunc);
+		if(!out){
+			ofLogVerbose("ofxImageSequenceVideo") << "can't write directory manifest \"" << manifestPath << "\"";
+			return;
+		}
+		out << manifestMagic << "\n" << key << "\n" << fileNames.size() << "\n";
+		for(const auto & name : fileNames){
+			out << name << "\n";
+		}
+		if(!out) return;
+	}
+	std::error_code err;
+	std::filesystem::rename(tmpPath, manifestPath, err); //atomic, readers never see a half written manifest
+	if(err) std::filesystem::remove(tmpPath, err);
+}
+
+
+vector<string> ofxImageSequenceVideoDirectory::listFiles(const string & dirPath, const vector<string> & extensions, const string & manifestPath){
+
+	if(manifestPath.empty()){
+		return scan(dirPath, extensions);
+	}
+
+	//the manifest is valid for this exact directory state and extension filter
+	std::error_code err;
+	auto mtime = std::filesystem::last_write_time(dirPath, err);
+	if(err){
+		return scan(dirPath, extensions);
+	}
+	string key = ofToString((long long)mtime.time_since_epoch().count());
+	for(const auto & ext : extensions){
+		key += " " + ext;
+	}
+
+	vector<string> fileNames;
+	if(readManifest(manifestPath, key, fileNames)){
+		return fileNames;
+	}
+	fileNames = scan(dirPath, extensions);
+	writeManifest(manifestPath, key, fileNames);
+	return fileNames;
+}
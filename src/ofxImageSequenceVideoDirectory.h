@@ -0,0 +1,40 @@
+//
+//  ofxImageSequenceVideoDirectory.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Directory listing for image sequences, made for huge (100k+ files) directories and slow (network) file systems.
+//On Linux the directory is read with getdents64() in large chunks, entries are filtered by type and extension in
+//place (no allocations for rejected entries), and the result is sorted in natural order (frame_9 < frame_10).
+//
+//Optionally, the listing is saved to a manifest file keyed on the directory's modification time (which changes
+//whenever files are added, removed or renamed), so that loading the same sequence again skips the scan altogether.
+class ofxImageSequenceVideoDirectory{
+
+public:
+
+	//names (not paths) of the non hidden files in dirPath with one of the given extensions (lowercase, no dot),
+	//sorted in natural order. If manifestPath is not empty, the listing is read from / saved to that file.
+	static vector<string> listFiles(const string & dirPath, const vector<string> & extensions, const string & manifestPath = "");
+
+	//names of the non hidden subdirectories of dirPath, sorted in natural order
+	static vector<string> listSubdirectories(const string & dirPath);
+
+	//where listFiles() would keep the manifest for dirPath: a hidden file next to the directory (so that writing it doesn't
+	//change the directory mtime), or a file named after the directory's path inside cacheDir
+	static string getManifestPath(const string & dirPath, const string & cacheDir = "");
+
+	//numeric aware string compare: runs of digits are compared by value, everything else char by char
+	static bool naturalLess(const string & a, const string & b);
+	static void naturalSort(vector<string> & names); //same order as naturalLess(), but much faster for large lists
+
+protected:
+
+	static vector<string> scan(const string & dirPath, const vector<string> & extensions);
+	static bool readManifest(const string & manifestPath, const string & key, vector<string> & fileNames);
+	static void writeManifest(const string & manifestPath, const string & key, const vector<string> & fileNames);
+};
@@ -0,0 +1,60 @@
+//
+//  ofxImageSequenceVideoMPSCQueue.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include <atomic>
+#include <utility>
+
+//Unbounded lock-free multiple-producer / single-consumer queue (Dmitry Vyukov's node based design).
+//push() is wait-free and can be called from any thread; pop() must only be called from one thread
+//(the consumer). A pop() racing with a push() can transiently report the queue as empty; the item
+//will be there on the next pop().
+template<typename T>
+class ofxImageSequenceVideoMPSCQueue{
+
+public:
+
+	ofxImageSequenceVideoMPSCQueue(){
+		Node * stub = new Node();
+		head.store(stub, std::memory_order_relaxed);
+		tail = stub;
+	}
+
+	~ofxImageSequenceVideoMPSCQueue(){
+		T item;
+		while(pop(item)){}
+		delete tail;
+	}
+
+	ofxImageSequenceVideoMPSCQueue(const ofxImageSequenceVideoMPSCQueue &) = delete;
+	ofxImageSequenceVideoMPSCQueue & operator=(const ofxImageSequenceVideoMPSCQueue &) = delete;
+
+	void push(T item){
+		Node * n = new Node();
+		n->item = std::move(item);
+		Node * prev = head.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n, std::memory_order_release);
+	}
+
+	bool pop(T & item){
+		Node * next = tail->next.load(std::memory_order_acquire);
+		if(next == nullptr) return false;
+		item = std::move(next->item);
+		delete tail;
+		tail = next; //next becomes the new stub
+		return true;
+	}
+
+protected:
+
+	struct Node{
+		std::atomic<Node*> next{nullptr};
+		T item;
+	};
+
+	std::atomic<Node*> head; //last pushed, producers side
+	Node * tail; //stub, consumer side
+};
@@ -0,0 +1,465 @@
+//
+//  ofxImageSequenceVideoPackedFile.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoPackedFile.h"
+#include "ofxImageSequenceVideoPageCache.h"
+#include "ofxImageSequenceVideoDXTView.h"
+#include "ofxDXT.h"
+#include "../lib/stb/stb_image.h"
+#include <fstream>
+#include <fcntl.h>
+#include <cerrno>
+
+#if defined(TARGET_WIN32)
+	#include <io.h>
+	#include <windows.h>
+#else
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+static const char isvMagic[4] = {'I', 'S', 'V', '1'};
+static const size_t isvHeaderSize = 32;
+static const size_t isvEntrySize = 24;
+
+//all our targets are little endian, so we just memcpy fields in and out of the file
+template<typename T> static void putField(char * dst, size_t & pos, T value){ memcpy(dst + pos, &value, sizeof(T)); pos += sizeof(T); }
+template<typename T> static T getField(const char * src, size_t & pos){ T value; memcpy(&value, src + pos, sizeof(T)); pos += sizeof(T); return value; }
+
+
+ofxImageSequenceVideoPackedFile::~ofxImageSequenceVideoPackedFile(){
+	close();
+}
+
+
+bool ofxImageSequenceVideoPackedFile::isPackedFile(const string & path){
+	return ofToLower(ofFilePath::getFileExt(path)) == "isv";
+}
+
+
+bool ofxImageSequenceVideoPackedFile::write(const vector<string> & filePaths, const string & outPath){
+
+	if(filePaths.empty()){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "can't write \"" << outPath << "\", no frames to pack!";
+		return false;
+	}
+
+	string ext = ofToLower(ofFilePath::getFileExt(filePaths[0]));
+	bool dxt = ext == "dxt";
+	int dxtCompressionType = 0;
+	if(ext.size() > 8){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "unsupported file extension \"" << ext << "\"";
+		return false;
+	}
+
+	//written next to outPath and renamed when complete, so a failed write never leaves a truncated .isv behind
+	string finalPath = ofToDataPath(outPath, true);
+	string tmpPath = finalPath + ".tmp";
+	std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "can't open \"" << outPath << "\" for writing!";
+		return false;
+	}
+	std::error_code err;
+
+	vector<Entry> entries(filePaths.size());
+	size_t indexSize = isvEntrySize * entries.size();
+	uint64_t offset = isvHeaderSize + indexSize;
+	vector<char> padding(payloadAlignment, 0);
+
+	//payload first - we fill in the index as we go, and write it at the end
+	out.seekp(isvHeaderSize + indexSize);
+	for(size_t i = 0; i < filePaths.size(); i++){
+		ofBuffer data;
+		ofxDXT::Data dxtData;
+		int w = 0, h = 0, nChannels = 0;
+		bool ok;
+		if(dxt){ //ofxDXT reads its own file format; we keep the bare blocks, in one compression type for the whole pack
+			ok = ofxDXT::loadFromDisk(filePaths[i], dxtData) && dxtData.size() > 0;
+			if(ok && i == 0) dxtCompressionType = dxtData.getCompressionType();
+			if(ok && dxtData.getCompressionType() != dxtCompressionType){
+				ofLogError("ofxImageSequenceVideoPackedFile") << "frame \"" << filePaths[i] << "\" has a different DXT compression type than the 1st frame";
+				ok = false;
+			}
+			if(ok){
+				w = dxtData.getWidth();
+				h = dxtData.getHeight();
+				nChannels = dxtCompressionType == ofxDXT::DXT1 ? 3 : 4;
+			}
+		}else{
+			data = ofBufferFromFile(filePaths[i], true);
+			ok = data.size() > 0;
+			if(ok) stbi_info_from_memory((const stbi_uc*)data.getData(), data.size(), &w, &h, &nChannels); //dimensions are informative, 0 if stb cant tell
+		}
+		if(!ok){
+			ofLogError("ofxImageSequenceVideoPackedFile") << "can't read frame \"" << filePaths[i] << "\"";
+			out.close();
+			std::filesystem::remove(tmpPath, err);
+			return false;
+		}
+		const char * bytes = dxt ? (const char *)dxtData.getData() : data.getData();
+		size_t size = dxt ? dxtData.size() : data.size();
+
+		size_t pad = (payloadAlignment - (offset % payloadAlignment)) % payloadAlignment;
+		out.write(padding.data(), pad);
+		offset += pad;
+
+		Entry & e = entries[i];
+		e.offset = offset;
+		e.size = size;
+		e.width = w;
+		e.height = h;
+		e.numChannels = nChannels;
+		out.write(bytes, size);
+		offset += size;
+	}
+
+	char header[isvHeaderSize] = {0};
+	size_t pos = 0;
+	memcpy(header, isvMagic, 4); pos += 4;
+	putField<uint32_t>(header, pos, version);
+	putField<uint32_t>(header, pos, entries.size());
+	putField<uint32_t>(header, pos, 0); //flags, unused for now
+	memcpy(header + pos, ext.c_str(), ext.size()); pos += 8;
+	putField<uint32_t>(header, pos, payloadAlignment);
+	putField<uint32_t>(header, pos, dxtCompressionType);
+
+	vector<char> index(indexSize);
+	pos = 0;
+	for(auto & e : entries){
+		putField<uint64_t>(index.data(), pos, e.offset);
+		putField<uint32_t>(index.data(), pos, e.size);
+		putField<uint32_t>(index.data(), pos, e.width);
+		putField<uint32_t>(index.data(), pos, e.height);
+		putField<uint32_t>(index.data(), pos, e.numChannels);
+	}
+
+	out.seekp(0);
+	out.write(header, isvHeaderSize);
+	out.write(index.data(), indexSize);
+	out.close();
+	if(!out.fail()){
+		std::filesystem::rename(tmpPath, finalPath, err);
+	}
+	if(out.fail() || err){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "failed to write \"" << outPath << "\"";
+		std::filesystem::remove(tmpPath, err);
+		return false;
+	}
+	ofLogNotice("ofxImageSequenceVideoPackedFile") << "packed " << entries.size() << " frames into \"" << outPath << "\" (" << offset / (1024 * 1024) << " Mb)";
+	return true;
+}
+
+
+bool ofxImageSequenceVideoPackedFile::open(const string & filePath){
+
+	close();
+	string fullPath = ofToDataPath(filePath, true);
+	#if defined(TARGET_WIN32)
+	fd = ::_open(fullPath.c_str(), _O_RDONLY | _O_BINARY);
+	#else
+	fd = ::open(fullPath.c_str(), O_RDONLY);
+	#endif
+	if(fd < 0){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "can't open \"" << filePath << "\"";
+		return false;
+	}
+
+	#if defined(TARGET_WIN32)
+	struct _stat64 st;
+	bool statOK = _fstat64(fd, &st) == 0;
+	#else
+	struct stat st;
+	bool statOK = fstat(fd, &st) == 0;
+	#endif
+	if(!statOK){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "can't stat \"" << filePath << "\"";
+		close();
+		return false;
+	}
+	uint64_t fileSize = st.st_size;
+
+	char header[isvHeaderSize];
+	if(pread(fd, header, isvHeaderSize, 0) != isvHeaderSize || memcmp(header, isvMagic, 4) != 0){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "\"" << filePath << "\" is not an .isv file!";
+		close();
+		return false;
+	}
+	size_t pos = 4;
+	uint32_t fileVersion = getField<uint32_t>(header, pos);
+	uint32_t numFrames = getField<uint32_t>(header, pos);
+	getField<uint32_t>(header, pos); //flags
+	if(fileVersion != version){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "unsupported .isv version " << fileVersion << " in \"" << filePath << "\"";
+		close();
+		return false;
+	}
+	fileExtension = string(header + pos, strnlen(header + pos, 8));
+	pos += 8;
+	getField<uint32_t>(header, pos); //payload alignment
+	dxtCompressionType = getField<uint32_t>(header, pos);
+
+	//don't trust numFrames until the file is big enough to hold its index; a corrupt count would have us allocate GBs
+	uint64_t indexSize = (uint64_t)isvEntrySize * numFrames;
+	if(isvHeaderSize + indexSize > fileSize){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "truncated index in \"" << filePath << "\"";
+		close();
+		return false;
+	}
+	vector<char> index(indexSize);
+	if(pread(fd, index.data(), index.size(), isvHeaderSize) != index.size()){
+		ofLogError("ofxImageSequenceVideoPackedFile") << "truncated index in \"" << filePath << "\"";
+		close();
+		return false;
+	}
+	entries.resize(numFrames);
+	pos = 0;
+	for(auto & e : entries){
+		e.offset = getField<uint64_t>(index.data(), pos);
+		e.size = getField<uint32_t>(index.data(), pos);
+		e.width = getField<uint32_t>(index.data(), pos);
+		e.height = getField<uint32_t>(index.data(), pos);
+		e.numChannels = getField<uint32_t>(index.data(), pos);
+		//every frame must be inside the file, so that neither views into the mapping nor pread() go past its end
+		if(e.offset > fileSize || e.size > fileSize - e.offset){
+			ofLogError("ofxImageSequenceVideoPackedFile") << "\"" << filePath << "\" is truncated!";
+			close();
+			return false;
+		}
+		//DXT frames are uploaded as they are, a short frame would have GL read past it
+		if(isDXT() && e.size != ofxImageSequenceVideoDXTView::getSize(e.width, e.height, dxtCompressionType)){
+			ofLogError("ofxImageSequenceVideoPackedFile") << "corrupt DXT frame in \"" << filePath << "\"";
+			close();
+			return false;
+		}
+	}
+	path = filePath;
+	if(!map()){
+		ofLogWarning("ofxImageSequenceVideoPackedFile") << "can't memory map \"" << filePath << "\", falling back to pread()";
+	}
+	return true;
+}
+
+
+bool ofxImageSequenceVideoPackedFile::map(){
+
+	#if defined(TARGET_WIN32)
+	HANDLE file = (HANDLE)_get_osfhandle(fd);
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size)) return false;
+	mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!mappingHandle) return false;
+	mapping = (const unsigned char *)MapViewOfFile((HANDLE)mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if(!mapping){
+		CloseHandle((HANDLE)mappingHandle);
+		mappingHandle = nullptr;
+		return false;
+	}
+	mappingSize = size.QuadPart;
+	#else
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0) return false;
+	void * ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if(ptr == MAP_FAILED) return false;
+	mapping = (const unsigned char *)ptr;
+	mappingSize = st.st_size;
+	mincoreReliable = st.st_uid == geteuid() || ::access(ofToDataPath(path, true).c_str(), W_OK) == 0;
+	#endif
+	//open() checked all entries against the file size; make sure the file didn't shrink since
+	for(auto & e : entries){
+		if(e.offset + e.size > mappingSize){
+			unmap();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void ofxImageSequenceVideoPackedFile::unmap(){
+	if(!mapping) return;
+	#if defined(TARGET_WIN32)
+	UnmapViewOfFile(mapping);
+	CloseHandle((HANDLE)mappingHandle);
+	mappingHandle = nullptr;
+	#else
+	munmap((void*)mapping, mappingSize);
+	#endif
+	mapping = nullptr;
+	mappingSize = 0;
+}
+
+
+void ofxImageSequenceVideoPackedFile::willNeed(int frame){
+	if(frame < 0 || frame >= (int)entries.size()) return;
+	#if !defined(TARGET_WIN32)
+	const Entry & e = entries[frame];
+	if(mapping){
+		static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+		uint64_t start = e.offset - (e.offset % pageSize); //madvise wants page aligned addresses
+		madvise((void*)(mapping + start), e.offset + e.size - start, MADV_WILLNEED);
+	}else if(fd >= 0){
+		#if defined(POSIX_FADV_WILLNEED)
+		posix_fadvise(fd, e.offset, e.size, POSIX_FADV_WILLNEED);
+		#endif
+	}
+	#endif
+}
+
+
+void ofxImageSequenceVideoPackedFile::dontNeed(int frame){
+	if(frame < 0 || frame >= (int)entries.size()) return;
+	#if !defined(TARGET_WIN32)
+	const Entry & e = entries[frame];
+	if(mapping){ //unmap our view of the pages first, mapped pages can't be dropped
+		static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+		uint64_t start = e.offset - (e.offset % pageSize);
+		madvise((void*)(mapping + start), e.offset + e.size - start, MADV_DONTNEED);
+	}
+	#if defined(POSIX_FADV_DONTNEED)
+	if(fd >= 0) posix_fadvise(fd, e.offset, e.size, POSIX_FADV_DONTNEED);
+	#endif
+	#endif
+}
+
+
+int ofxImageSequenceVideoPackedFile::isResident(int frame){
+	if(frame < 0 || frame >= (int)entries.size()) return -1;
+	const Entry & e = entries[frame];
+	if(mapping && mincoreReliable) return ofxImageSequenceVideoPageCache::isResident(mapping + e.offset, e.size);
+	return -1; //unmapped files are probed as they are read, see readFrame()
+}
+
+
+void ofxImageSequenceVideoPackedFile::touchFrame(int frame){
+	if(!mapping || frame < 0 || frame >= (int)entries.size()) return;
+	const Entry & e = entries[frame];
+	if(e.size == 0) return;
+	const size_t pageSize = 4096; //smallest page size we'll find, touching more often than needed is harmless
+	volatile unsigned char sum = 0;
+	for(uint64_t i = 0; i < e.size; i += pageSize){
+		sum += mapping[e.offset + i];
+	}
+	sum += mapping[e.offset + e.size - 1];
+}
+
+
+int ofxImageSequenceVideoPackedFile::getDirectFd(){
+	std::lock_guard<std::mutex> lock(directFdMutex);
+	#if defined(O_DIRECT)
+	if(!directFdOpened && fd >= 0){
+		directFd = ::open(ofToDataPath(path, true).c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+		struct stat a, b; //must be the file we opened, not one re-packed at the same path since
+		if(directFd >= 0 && (fstat(fd, &a) != 0 || fstat(directFd, &b) != 0 || a.st_ino != b.st_ino || a.st_dev != b.st_dev)){
+			::close(directFd);
+			directFd = -1;
+		}
+	}
+	#endif
+	directFdOpened = true;
+	return directFd;
+}
+
+
+void ofxImageSequenceVideoPackedFile::close(){
+	unmap();
+	if(fd >= 0){
+		#if defined(TARGET_WIN32)
+		::_close(fd);
+		#else
+		::close(fd);
+		#endif
+	}
+	#if !defined(TARGET_WIN32)
+	if(directFd >= 0) ::close(directFd);
+	#endif
+	fd = -1;
+	directFd = -1;
+	directFdOpened = false;
+	entries.clear();
+	path.clear();
+	fileExtension.clear();
+	dxtCompressionType = 0;
+}
+
+
+bool ofxImageSequenceVideoPackedFile::readFrame(int frame, ofBuffer & buffer, int * pageCacheHit){
+	if(fd < 0 || frame < 0 || frame >= (int)entries.size()) return false;
+	const Entry & e = entries[frame];
+	buffer.allocate(e.size);
+	if(mapping){
+		if(pageCacheHit) *pageCacheHit = isResident(frame);
+		memcpy(buffer.getData(), mapping + e.offset, e.size);
+		return true;
+	}
+	return readRange(fd, buffer.getData(), e.size, e.offset, pageCacheHit);
+}
+
+
+bool ofxImageSequenceVideoPackedFile::readFile(const string & filePath, ofBuffer & buffer, int * pageCacheHit){
+
+	string fullPath = ofToDataPath(filePath, true);
+	#if defined(TARGET_WIN32)
+	int fd = ::_open(fullPath.c_str(), _O_RDONLY | _O_BINARY);
+	#else
+	int fd = ::open(fullPath.c_str(), O_RDONLY | O_CLOEXEC);
+	#endif
+	if(fd < 0) return false;
+
+	bool ok = false;
+	#if defined(TARGET_WIN32)
+	struct _stat64 st;
+	if(_fstat64(fd, &st) == 0){
+	#else
+	struct stat st;
+	if(fstat(fd, &st) == 0){
+	#endif
+		size_t size = (size_t)st.st_size;
+		buffer.allocate(size); //ofBuffer keeps its capacity, so this only allocates when the frame is bigger than any before
+		ok = size > 0 && readRange(fd, buffer.getData(), size, 0, pageCacheHit);
+	}
+
+	#if defined(TARGET_WIN32)
+	::_close(fd);
+	#else
+	::close(fd);
+	#endif
+	return ok;
+}
+
+
+bool ofxImageSequenceVideoPackedFile::readRange(int fd, void * dst, size_t numBytes, uint64_t offset, int * pageCacheHit){
+	size_t numCached = 0;
+	if(pageCacheHit){ //whatever is cached is read right away, then the rest (if any) from the disk
+		*pageCacheHit = ofxImageSequenceVideoPageCache::readCached(fd, dst, numBytes, offset, numCached);
+	}
+	return numCached == numBytes || pread(fd, (char*)dst + numCached, numBytes - numCached, offset + numCached) == numBytes - numCached;
+}
+
+
+size_t ofxImageSequenceVideoPackedFile::pread(int fd, void * dst, size_t numBytes, uint64_t offset){
+
+	size_t total = 0;
+	char * ptr = (char*)dst;
+	while(total < numBytes){
+		#if defined(TARGET_WIN32)
+		OVERLAPPED ov = {0};
+		ov.Offset = (DWORD)(offset & 0xFFFFFFFF);
+		ov.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD numRead = 0;
+		if(!ReadFile((HANDLE)_get_osfhandle(fd), ptr, (DWORD)MIN(numBytes - total, (size_t)0x7FFFFFFF), &numRead, &ov) || numRead == 0) break;
+		#else
+		ssize_t numRead = ::pread(fd, ptr, numBytes - total, offset);
+		if(numRead < 0 && errno == EINTR) continue;
+		if(numRead <= 0) break;
+		#endif
+		total += numRead;
+		ptr += numRead;
+		offset += numRead;
+	}
+	return total;
+}
@@ -0,0 +1,108 @@
+//
+//  ofxImageSequenceVideoPackedFile.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Single file container for image sequences (.isv). Holds all encoded frames (jpg, png, etc - as
+//they were on disk, no re-encoding) plus an index with the offset, size and dimensions of each frame.
+//DXT frames are stored as their bare compressed blocks (file extension "dxt"), so they can be uploaded from the mapping.
+//
+//Layout (little endian):
+//	Header			32 bytes - magic "ISV1", version, numFrames, flags, file extension (8 chars), payload alignment,
+//					DXT compression type (ofxDXT::DXT1, DXT3 or DXT5; 0 if the frames are not DXT)
+//	Index			numFrames x Entry (24 bytes each)
+//	Payload			encoded frames, each one starting at a multiple of the payload alignment
+//
+//The whole file is memory mapped on open(), so workers can decode straight from a view into the
+//mapping (getFrameData()) without copying the encoded bytes. If mapping fails (ie 32 bit address space)
+//frames are read with pread() at known offsets instead. Any number of threads can read concurrently.
+class ofxImageSequenceVideoPackedFile{
+
+public:
+
+	static const uint32_t version = 1;
+	static const uint32_t payloadAlignment = 4096; //keeps every frame O_DIRECT / page aligned
+
+	struct Entry{
+		uint64_t offset = 0;
+		uint32_t size = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t numChannels = 0;
+	};
+
+	ofxImageSequenceVideoPackedFile(){};
+	~ofxImageSequenceVideoPackedFile();
+
+	//packs all the given image files into a single .isv file at outPath
+	static bool write(const vector<string> & filePaths, const string & outPath);
+	static bool isPackedFile(const string & path); //just checks the file extension
+
+	bool open(const string & path);
+	void close();
+	bool isOpen(){ return fd >= 0; }
+
+	int getNumFrames(){ return entries.size(); }
+	const Entry & getEntry(int frame){ return entries[frame]; }
+	const string & getFileExtension(){ return fileExtension; } //of the packed frames; "jpg", "png", etc
+	bool isDXT(){ return fileExtension == "dxt"; }
+	int getDXTCompressionType(){ return dxtCompressionType; } //of all the frames, if isDXT()
+
+	//thread safe, copies the frame's encoded bytes into buffer. pageCacheHit: if given, set to whether they were all in
+	//the page cache (see isResident())
+	bool readFrame(int frame, ofBuffer & buffer, int * pageCacheHit = nullptr);
+
+	//zero copy view of the frame's encoded bytes (Entry::size bytes long), nullptr if the file could not be mapped
+	const unsigned char * getFrameData(int frame){ return mapping ? mapping + entries[frame].offset : nullptr; }
+	bool isMapped(){ return mapping != nullptr; }
+
+	//tell the OS we will read that frame soon, so it can start paging it in. Thread safe and non blocking
+	void willNeed(int frame);
+
+	//the frame has been shown and won't be needed for a while, let the OS drop it from the page cache
+	void dontNeed(int frame);
+	int isResident(int frame); //1 if the whole frame is in the page cache, 0 if not, -1 if we can't tell (ie not mapped)
+
+	//reads a byte of each of the frame's mapped pages, so that any page faults (disk reads) happen on the calling thread
+	//and not later on, whoever decodes from getFrameData(). Does nothing if the file is not mapped
+	void touchFrame(int frame);
+
+	const string & getPath(){ return path; }
+
+	//the open file, for readers doing their own I/O on it (see ofxImageSequenceVideoUringReader). Valid until close()
+	int getFd(){ return fd; }
+	//the same file opened with O_DIRECT, opened on the 1st call; -1 if the platform / file system doesn't support it.
+	//Thread safe, valid until close()
+	int getDirectFd();
+
+	//reads a whole (loose) file into buffer with a single pread(), reusing buffer's memory if it's big enough. Thread safe.
+	//pageCacheHit: if given, set to 1 if the file was all in the page cache, 0 if not, -1 if the OS can't tell
+	static bool readFile(const string & filePath, ofBuffer & buffer, int * pageCacheHit = nullptr);
+
+protected:
+
+	static size_t pread(int fd, void * dst, size_t numBytes, uint64_t offset);
+	static bool readRange(int fd, void * dst, size_t numBytes, uint64_t offset, int * pageCacheHit); //pread(), probing if asked to
+
+	bool map();
+	void unmap();
+
+	int fd = -1;
+	int directFd = -1;
+	bool directFdOpened = false; //tried already
+	std::mutex directFdMutex;
+	const unsigned char * mapping = nullptr;
+	size_t mappingSize = 0;
+	bool mincoreReliable = false; //see ofxImageSequenceVideoPageCache::isResident()
+	#if defined(TARGET_WIN32)
+	void * mappingHandle = nullptr;
+	#endif
+	string path;
+	string fileExtension;
+	int dxtCompressionType = 0;
+	vector<Entry> entries;
+};
@@ -0,0 +1,105 @@
+//
+//  ofxImageSequenceVideoPageCache.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoPageCache.h"
+#include <fcntl.h>
+
+#if !defined(TARGET_WIN32)
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/uio.h>
+	#include <cerrno>
+#endif
+
+#if defined(__APPLE__)
+	typedef char MincoreVec; //mincore() takes a char vector on macOS, unsigned char on Linux
+#else
+	typedef unsigned char MincoreVec;
+#endif
+
+
+void ofxImageSequenceVideoPageCache::willNeed(const string & path){
+	#if !defined(TARGET_WIN32)
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0) return;
+	#if defined(__APPLE__)
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0){
+		struct radvisory ra;
+		ra.ra_offset = 0;
+		ra.ra_count = (int)MIN(st.st_size, (off_t)INT_MAX);
+		fcntl(fd, F_RDADVISE, &ra);
+	}
+	#elif defined(POSIX_FADV_WILLNEED)
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED); //0 len == whole file
+	#endif
+	::close(fd);
+	#endif
+}
+
+
+void ofxImageSequenceVideoPageCache::dontNeed(const string & path){
+	#if !defined(TARGET_WIN32) && defined(POSIX_FADV_DONTNEED)
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0) return;
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	::close(fd);
+	#endif
+}
+
+
+int ofxImageSequenceVideoPageCache::isResident(const void * mappedData, size_t size){
+	#if !defined(TARGET_WIN32)
+	if(!mappedData || size == 0) return -1;
+	static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)mappedData & ~(pageSize - 1); //mincore wants page aligned addresses
+	size_t len = (uintptr_t)mappedData + size - start;
+	size_t numPages = (len + pageSize - 1) / pageSize;
+	MincoreVec small[256];
+	std::vector<MincoreVec> large;
+	MincoreVec * vec = small;
+	if(numPages > 256){
+		large.resize(numPages);
+		vec = large.data();
+	}
+	if(mincore((void*)start, len, vec) != 0) return -1;
+	for(size_t i = 0; i < numPages; i++){
+		if((vec[i] & 1) == 0) return 0;
+	}
+	return 1;
+	#else
+	return -1;
+	#endif
+}
+
+
+#if defined(__linux__) && defined(RWF_NOWAIT)
+
+int ofxImageSequenceVideoPageCache::readCached(int fd, void * dst, size_t numBytes, uint64_t offset, size_t & numRead){
+	//RWF_NOWAIT reads stop at the 1st page that's not cached (EAGAIN if it's the 1st one) instead of going to the disk
+	numRead = 0;
+	char * ptr = (char*)dst;
+	while(numRead < numBytes){
+		struct iovec iov = {ptr + numRead, numBytes - numRead};
+		ssize_t n = preadv2(fd, &iov, 1, offset + numRead, RWF_NOWAIT);
+		if(n < 0 && errno == EINTR) continue;
+		if(n < 0 && errno == EAGAIN) return 0;
+		if(n < 0) return -1; //ie EOPNOTSUPP, the file system doesn't do non blocking reads
+		if(n == 0) return 0; //shorter than expected, the caller's read will find out
+		numRead += n;
+	}
+	return 1;
+}
+
+#else
+
+int ofxImageSequenceVideoPageCache::readCached(int, void *, size_t, uint64_t, size_t & numRead){
+	numRead = 0;
+	return -1;
+}
+
+#endif
@@ -0,0 +1,28 @@
+//
+//  ofxImageSequenceVideoPageCache.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Thin wrappers around the OS page cache hints and residency queries, so the player can tell the kernel which
+//files it will read soon (and which ones it's done with), and find out if a read hit the disk.
+//Linux: posix_fadvise() + preadv2(RWF_NOWAIT) / mincore(). macOS: fcntl(F_RDADVISE) + mincore(), no DONTNEED.
+//Windows: no-ops. All functions are thread safe, and they do block on open() - don't call them from the main thread.
+class ofxImageSequenceVideoPageCache{
+
+public:
+
+	static void willNeed(const string & path); //start reading the whole file in the background
+	static void dontNeed(const string & path); //drop the file's clean pages from the page cache
+
+	//reads as much of the range as is in the page cache, without waiting on the disk; numRead bytes are read.
+	//1 if it was all there, 0 if not, -1 if the OS can't tell. Costs nothing over a regular read when it's a hit
+	static int readCached(int fd, void * dst, size_t numBytes, uint64_t offset, size_t & numRead);
+
+	//1 if all of the mapped range is in the page cache, 0 if not, -1 if we can't tell. Only for mappings of files the
+	//process owns or could write: for any other file, Linux (5.2+) reports all pages as resident
+	static int isResident(const void * mappedData, size_t size);
+};
@@ -0,0 +1,355 @@
+//
+//  ofxImageSequenceVideoPixelConvert.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoPixelConvert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define ISV_CONVERT_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define ISV_TARGET(isa) //msvc compiles any intrinsic, no per function flags needed
+	#else
+		#define ISV_TARGET(isa) __attribute__((target(isa)))
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define ISV_CONVERT_NEON
+	#include <arm_neon.h>
+#endif
+
+//scalar versions - the fallback, and the tails of the SIMD ones. Each SIMD kernel returns how many pixels it did.
+
+template<bool bgra>
+static void rgbTo4Scalar(const unsigned char * __restrict src, unsigned char * __restrict dst, size_t numPixels){
+	for(size_t i = 0; i < numPixels; i++){
+		dst[0] = src[bgra ? 2 : 0];
+		dst[1] = src[1];
+		dst[2] = src[bgra ? 0 : 2];
+		dst[3] = 255;
+		src += 3;
+		dst += 4;
+	}
+}
+
+static void rgbaToRgbScalar(const unsigned char * __restrict src, unsigned char * __restrict dst, size_t numPixels){
+	for(size_t i = 0; i < numPixels; i++){
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+		src += 4;
+		dst += 3;
+	}
+}
+
+static void swapRedBlueScalar(const unsigned char * __restrict src, unsigned char * __restrict dst, size_t numPixels){
+	for(size_t i = 0; i < numPixels; i++){
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+		dst[3] = src[3];
+		src += 4;
+		dst += 4;
+	}
+}
+
+#if defined(ISV_CONVERT_X86)
+
+//pshufb masks, per 16 byte lane; -1 zeroes the byte
+template<bool bgra> ISV_TARGET("ssse3")
+static __m128i rgbTo4Mask(){
+	return bgra ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+				: _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+}
+
+ISV_TARGET("ssse3") static __m128i rgbaToRgbMask(){
+	return _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+}
+
+ISV_TARGET("ssse3") static __m128i swapRedBlueMask(){
+	return _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+}
+
+//4 pixels per iteration; the 16 byte load reads 4 bytes past the 4th pixel, hence the + 6
+template<bool bgra> ISV_TARGET("ssse3")
+static size_t rgbTo4Ssse3(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m128i mask = rgbTo4Mask<bgra>();
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	size_t i = 0;
+	for(; i + 6 <= numPixels; i += 4){
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 3));
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+	}
+	return i;
+}
+
+//8 pixels per iteration, 4 per lane
+template<bool bgra> ISV_TARGET("avx2")
+static size_t rgbTo4Avx2(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m256i mask = _mm256_broadcastsi128_si256(rgbTo4Mask<bgra>());
+	const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+	size_t i = 0;
+	for(; i + 10 <= numPixels; i += 8){
+		const unsigned char * s = src + i * 3;
+		__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+											_mm_loadu_si128((const __m128i *)(s + 12)), 1);
+		_mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(v, mask), alpha));
+	}
+	return i;
+}
+
+//the 16 byte stores write 4 bytes of garbage past the 4th pixel, overwritten by the next one; hence the + 6
+ISV_TARGET("ssse3")
+static size_t rgbaToRgbSsse3(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m128i mask = rgbaToRgbMask();
+	size_t i = 0;
+	for(; i + 6 <= numPixels; i += 4){
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+		_mm_storeu_si128((__m128i *)(dst + i * 3), _mm_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+ISV_TARGET("avx2")
+static size_t rgbaToRgbAvx2(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m256i mask = _mm256_broadcastsi128_si256(rgbaToRgbMask());
+	size_t i = 0;
+	for(; i + 10 <= numPixels; i += 8){
+		__m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i * 4)), mask);
+		unsigned char * d = dst + i * 3;
+		_mm_storeu_si128((__m128i *)d, _mm256_castsi256_si128(v));
+		_mm_storeu_si128((__m128i *)(d + 12), _mm256_extracti128_si256(v, 1));
+	}
+	return i;
+}
+
+ISV_TARGET("ssse3")
+static size_t swapRedBlueSsse3(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m128i mask = swapRedBlueMask();
+	size_t i = 0;
+	for(; i + 4 <= numPixels; i += 4){
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+ISV_TARGET("avx2")
+static size_t swapRedBlueAvx2(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	const __m256i mask = _mm256_broadcastsi128_si256(swapRedBlueMask());
+	size_t i = 0;
+	for(; i + 8 <= numPixels; i += 8){
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+		_mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_shuffle_epi8(v, mask));
+	}
+	return i;
+}
+
+#elif defined(ISV_CONVERT_NEON)
+
+//16 pixels per iteration; the interleaving loads / stores do the shuffling
+template<bool bgra>
+static size_t rgbTo4Neon(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	size_t i = 0;
+	for(; i + 16 <= numPixels; i += 16){
+		uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+		uint8x16x4_t out;
+		out.val[0] = rgb.val[bgra ? 2 : 0];
+		out.val[1] = rgb.val[1];
+		out.val[2] = rgb.val[bgra ? 0 : 2];
+		out.val[3] = vdupq_n_u8(255);
+		vst4q_u8(dst + i * 4, out);
+	}
+	return i;
+}
+
+static size_t rgbaToRgbNeon(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	size_t i = 0;
+	for(; i + 16 <= numPixels; i += 16){
+		uint8x16x4_t rgba = vld4q_u8(src + i * 4);
+		uint8x16x3_t out;
+		out.val[0] = rgba.val[0];
+		out.val[1] = rgba.val[1];
+		out.val[2] = rgba.val[2];
+		vst3q_u8(dst + i * 3, out);
+	}
+	return i;
+}
+
+static size_t swapRedBlueNeon(const unsigned char * src, unsigned char * dst, size_t numPixels){
+	size_t i = 0;
+	for(; i + 16 <= numPixels; i += 16){
+		uint8x16x4_t v = vld4q_u8(src + i * 4);
+		uint8x16_t r = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = r;
+		vst4q_u8(dst + i * 4, v);
+	}
+	return i;
+}
+
+#endif
+
+
+ofxImageSequenceVideoPixelConvert::Isa ofxImageSequenceVideoPixelConvert::getBestIsa(){
+
+	static const Isa best = [](){
+		#if defined(ISV_CONVERT_X86)
+			#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			int maxLeaf = info[0];
+			__cpuid(info, 1);
+			bool ssse3 = (info[2] & (1 << 9)) != 0;
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx2 = false;
+			if(maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6){ //the OS saves the ymm registers
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+			}
+			#else
+			__builtin_cpu_init();
+			bool ssse3 = __builtin_cpu_supports("ssse3");
+			bool avx2 = __builtin_cpu_supports("avx2");
+			#endif
+			return avx2 ? AVX2 : ssse3 ? SSSE3 : SCALAR;
+		#elif defined(ISV_CONVERT_NEON)
+			return NEON;
+		#else
+			return SCALAR;
+		#endif
+	}();
+	return best;
+}
+
+
+bool ofxImageSequenceVideoPixelConvert::isIsaAvailable(Isa isa){
+	Isa best = getBestIsa();
+	switch(isa){
+		case AUTO: case SCALAR: return true;
+		case SSSE3: return best == SSSE3 || best == AVX2;
+		case AVX2: return best == AVX2;
+		case NEON: return best == NEON;
+	}
+	return false;
+}
+
+
+string ofxImageSequenceVideoPixelConvert::getIsaName(Isa isa){
+	switch(isa){
+		case AUTO: return getIsaName(getBestIsa());
+		case SCALAR: return "Scalar";
+		case SSSE3: return "SSSE3";
+		case AVX2: return "AVX2";
+		case NEON: return "NEON";
+	}
+	return "";
+}
+
+
+string ofxImageSequenceVideoPixelConvert::getFormatName(ofPixelFormat format){
+	switch(format){
+		case OF_PIXELS_GRAY: return "GRAY";
+		case OF_PIXELS_GRAY_ALPHA: return "GRAY_ALPHA";
+		case OF_PIXELS_RGB: return "RGB";
+		case OF_PIXELS_BGR: return "BGR";
+		case OF_PIXELS_RGBA: return "RGBA";
+		case OF_PIXELS_BGRA: return "BGRA";
+		default: return "OTHER";
+	}
+}
+
+
+static ofxImageSequenceVideoPixelConvert::Isa resolve(ofxImageSequenceVideoPixelConvert::Isa isa){
+	if(isa == ofxImageSequenceVideoPixelConvert::AUTO) return ofxImageSequenceVideoPixelConvert::getBestIsa();
+	return ofxImageSequenceVideoPixelConvert::isIsaAvailable(isa) ? isa : ofxImageSequenceVideoPixelConvert::SCALAR;
+}
+
+
+bool ofxImageSequenceVideoPixelConvert::canConvert(ofPixelFormat src, ofPixelFormat dst){
+	if(src == OF_PIXELS_RGB) return dst == OF_PIXELS_RGBA || dst == OF_PIXELS_BGRA;
+	if(src == OF_PIXELS_RGBA) return dst == OF_PIXELS_RGB || dst == OF_PIXELS_BGRA;
+	if(src == OF_PIXELS_BGRA) return dst == OF_PIXELS_RGBA;
+	return false;
+}
+
+
+bool ofxImageSequenceVideoPixelConvert::convert(const ofPixels & src, ofPixels & dst, ofPixelFormat format, Isa isa){
+
+	ofPixelFormat srcFormat = src.getPixelFormat();
+	if(!canConvert(srcFormat, format)) return false;
+	dst.allocate(src.getWidth(), src.getHeight(), format);
+	size_t numPixels = src.getWidth() * src.getHeight();
+
+	if(srcFormat == OF_PIXELS_RGB){
+		if(format == OF_PIXELS_RGBA) rgbToRgba(src.getData(), dst.getData(), numPixels, isa);
+		else rgbToBgra(src.getData(), dst.getData(), numPixels, isa);
+	}else if(format == OF_PIXELS_RGB){
+		rgbaToRgb(src.getData(), dst.getData(), numPixels, isa);
+	}else{
+		rgbaToBgra(src.getData(), dst.getData(), numPixels, isa);
+	}
+	return true;
+}
+
+
+void ofxImageSequenceVideoPixelConvert::rgbToRgba(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa){
+	size_t i = 0;
+	switch(resolve(isa)){
+		#if defined(ISV_CONVERT_X86)
+		case AVX2: i = rgbTo4Avx2<false>(src, dst, numPixels); break;
+		case SSSE3: i = rgbTo4Ssse3<false>(src, dst, numPixels); break;
+		#elif defined(ISV_CONVERT_NEON)
+		case NEON: i = rgbTo4Neon<false>(src, dst, numPixels); break;
+		#endif
+		default: break;
+	}
+	rgbTo4Scalar<false>(src + i * 3, dst + i * 4, numPixels - i);
+}
+
+
+void ofxImageSequenceVideoPixelConvert::rgbToBgra(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa){
+	size_t i = 0;
+	switch(resolve(isa)){
+		#if defined(ISV_CONVERT_X86)
+		case AVX2: i = rgbTo4Avx2<true>(src, dst, numPixels); break;
+		case SSSE3: i = rgbTo4Ssse3<true>(src, dst, numPixels); break;
+		#elif defined(ISV_CONVERT_NEON)
+		case NEON: i = rgbTo4Neon<true>(src, dst, numPixels); break;
+		#endif
+		default: break;
+	}
+	rgbTo4Scalar<true>(src + i * 3, dst + i * 4, numPixels - i);
+}
+
+
+void ofxImageSequenceVideoPixelConvert::rgbaToRgb(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa){
+	size_t i = 0;
+	switch(resolve(isa)){
+		#if defined(ISV_CONVERT_X86)
+		case AVX2: i = rgbaToRgbAvx2(src, dst, numPixels); break;
+		case SSSE3: i = rgbaToRgbSsse3(src, dst, numPixels); break;
+		#elif defined(ISV_CONVERT_NEON)
+		case NEON: i = rgbaToRgbNeon(src, dst, numPixels); break;
+		#endif
+		default: break;
+	}
+	rgbaToRgbScalar(src + i * 4, dst + i * 3, numPixels - i);
+}
+
+
+void ofxImageSequenceVideoPixelConvert::rgbaToBgra(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa){
+	size_t i = 0;
+	switch(resolve(isa)){
+		#if defined(ISV_CONVERT_X86)
+		case AVX2: i = swapRedBlueAvx2(src, dst, numPixels); break;
+		case SSSE3: i = swapRedBlueSsse3(src, dst, numPixels); break;
+		#elif defined(ISV_CONVERT_NEON)
+		case NEON: i = swapRedBlueNeon(src, dst, numPixels); break;
+		#endif
+		default: break;
+	}
+	swapRedBlueScalar(src + i * 4, dst + i * 4, numPixels - i);
+}
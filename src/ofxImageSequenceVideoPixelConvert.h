@@ -0,0 +1,42 @@
+//
+//  ofxImageSequenceVideoPixelConvert.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Pixel layout conversions for the decode workers - see ofxImageSequenceVideo::setOutputPixelFormat().
+//RGB -> RGBA / BGRA (opaque alpha added), RGBA -> RGB (alpha dropped) and RGBA -> BGRA (red / blue swapped).
+//Each kernel has SSSE3, AVX2 and NEON versions plus a scalar fallback; the fastest one the cpu supports is picked
+//at runtime on x86, NEON is used whenever the build targets it. All methods are thread safe.
+class ofxImageSequenceVideoPixelConvert{
+
+public:
+
+	enum Isa{
+		AUTO, //the best one available
+		SCALAR,
+		SSSE3,
+		AVX2,
+		NEON
+	};
+
+	static Isa getBestIsa();
+	static bool isIsaAvailable(Isa isa);
+	static string getIsaName(Isa isa);
+	static string getFormatName(ofPixelFormat format); //"RGB", "BGRA"...
+
+	//if there's a kernel from pixels in src format to dst format
+	static bool canConvert(ofPixelFormat src, ofPixelFormat dst);
+
+	//converts src into dst (allocated by this, in format). false if there's no kernel for it (see canConvert())
+	static bool convert(const ofPixels & src, ofPixels & dst, ofPixelFormat format, Isa isa = AUTO);
+
+	//the kernels, numPixels pixels from src to dst; they can't overlap
+	static void rgbToRgba(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa = AUTO);
+	static void rgbToBgra(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa = AUTO);
+	static void rgbaToRgb(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa = AUTO);
+	static void rgbaToBgra(const unsigned char * src, unsigned char * dst, size_t numPixels, Isa isa = AUTO); //also BGRA -> RGBA
+};
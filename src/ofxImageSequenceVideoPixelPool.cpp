@@ -0,0 +1,85 @@
+//
+//  ofxImageSequenceVideoPixelPool.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoPixelPool.h"
+
+
+void ofxImageSequenceVideoPixelPool::setMaxBuffers(size_t num){
+	std::lock_guard<std::mutex> lock(mutex);
+	maxBuffers = num;
+	if(freeBuffers.size() > maxBuffers){
+		freeBuffers.resize(maxBuffers);
+	}
+}
+
+
+void ofxImageSequenceVideoPixelPool::acquire(ofPixels & pixels){
+	if(pixels.isAllocated()) return;
+	std::lock_guard<std::mutex> lock(mutex);
+	if(freeBuffers.size()){
+		pixels.swap(freeBuffers.back());
+		freeBuffers.pop_back();
+	}
+}
+
+
+void ofxImageSequenceVideoPixelPool::release(ofPixels & pixels){
+	if(!pixels.isAllocated()) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(format == OF_PIXELS_UNKNOWN){ //1st frame we see defines the pool's buffer size
+			width = pixels.getWidth();
+			height = pixels.getHeight();
+			format = pixels.getPixelFormat();
+		}
+		if(freeBuffers.size() < maxBuffers && matchesPool(pixels)){
+			freeBuffers.emplace_back();
+			freeBuffers.back().swap(pixels);
+			return;
+		}
+	}
+	pixels.clear(); //free outside the lock
+}
+
+
+void ofxImageSequenceVideoPixelPool::prefill(const ofPixels & model){
+	std::lock_guard<std::mutex> lock(mutex);
+	width = model.getWidth();
+	height = model.getHeight();
+	format = model.getPixelFormat();
+	while(freeBuffers.size() < maxBuffers){
+		freeBuffers.emplace_back();
+		freeBuffers.back().allocate(width, height, format);
+	}
+}
+
+
+void ofxImageSequenceVideoPixelPool::clear(){
+	std::lock_guard<std::mutex> lock(mutex);
+	freeBuffers.clear();
+	format = OF_PIXELS_UNKNOWN;
+}
+
+
+size_t ofxImageSequenceVideoPixelPool::getNumFreeBuffers(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return freeBuffers.size();
+}
+
+
+size_t ofxImageSequenceVideoPixelPool::getFreeBytes(){
+	std::lock_guard<std::mutex> lock(mutex);
+	size_t bytes = 0;
+	for(auto & pixels : freeBuffers){
+		bytes += pixels.getTotalBytes();
+	}
+	return bytes;
+}
+
+
+bool ofxImageSequenceVideoPixelPool::matchesPool(const ofPixels & pixels){
+	return pixels.getWidth() == width && pixels.getHeight() == height && pixels.getPixelFormat() == format;
+}
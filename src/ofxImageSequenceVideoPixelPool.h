@@ -0,0 +1,54 @@
+//
+//  ofxImageSequenceVideoPixelPool.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Recycles decoded frame buffers, so that steady state playback does no malloc/free per frame.
+//Frames of a sequence all have the same size, so once a buffer is allocated it can be handed back
+//to a decoder as is; ofPixels::allocate() is a no-op when asked for the size it already has.
+//All methods are thread safe.
+class ofxImageSequenceVideoPixelPool{
+
+public:
+
+	void setMaxBuffers(size_t num); //how many free buffers to keep around at most
+
+	//if pixels is empty, swaps a recycled buffer into it (if there is one)
+	void acquire(ofPixels & pixels);
+
+	//moves the buffer out of pixels (leaving it empty) and keeps it for reuse, or frees it if the pool is full
+	//or the buffer doesn't match the size / format of the pool
+	void release(ofPixels & pixels);
+
+	//pre-allocates buffers matching that frame's size and format, up to the max
+	void prefill(const ofPixels & model);
+
+	void clear();
+
+	//decoders call this after writing into an acquired buffer, to track whether they had to (re)allocate
+	void reportDecode(bool allocated){ allocated ? numAllocations++ : numReuses++; }
+
+	uint64_t getNumAllocations(){ return numAllocations; }
+	uint64_t getNumReuses(){ return numReuses; }
+	size_t getNumFreeBuffers();
+	size_t getFreeBytes(); //held by the free buffers
+	size_t getMaxBuffers(){ return maxBuffers; }
+
+protected:
+
+	bool matchesPool(const ofPixels & pixels); //call with mutex locked
+
+	std::mutex mutex;
+	vector<ofPixels> freeBuffers;
+	size_t maxBuffers = 0;
+	size_t width = 0;
+	size_t height = 0;
+	ofPixelFormat format = OF_PIXELS_UNKNOWN;
+
+	std::atomic<uint64_t> numAllocations{0};
+	std::atomic<uint64_t> numReuses{0};
+};
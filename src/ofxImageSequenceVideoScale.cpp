@@ -0,0 +1,109 @@
+//
+//  ofxImageSequenceVideoScale.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoScale.h"
+
+
+//2nd pass, one dst row from the row sums. Template args so the block loops are fully unrolled
+template<int numChannels, int factor>
+static void sumColumns(const uint16_t * __restrict sums, unsigned char * __restrict out, size_t w){
+	constexpr int shift = factor == 2 ? 2 : factor == 4 ? 4 : 6;
+	constexpr uint16_t round = (1 << shift) / 2;
+	for(size_t x = 0; x < w; x++){
+		for(int c = 0; c < numChannels; c++){
+			uint16_t sum = round;
+			for(int k = 0; k < factor; k++) sum += sums[k * numChannels + c];
+			out[c] = (unsigned char)(sum >> shift);
+		}
+		sums += factor * numChannels;
+		out += numChannels;
+	}
+}
+
+//edge blocks, with less than factor x factor src pixels: the plain average of the ones there are
+static void averageBlock(const uint16_t * sums, unsigned char * out, size_t numChannels, int numCols, int numRows){
+	int count = numCols * numRows;
+	for(size_t c = 0; c < numChannels; c++){
+		int sum = count / 2;
+		for(int k = 0; k < numCols; k++) sum += sums[k * numChannels + c];
+		out[c] = (unsigned char)(sum / count);
+	}
+}
+
+template<int numChannels>
+static void sumColumns(const uint16_t * sums, unsigned char * out, size_t w, int factor){
+	switch(factor){
+		case 2: sumColumns<numChannels, 2>(sums, out, w); break;
+		case 4: sumColumns<numChannels, 4>(sums, out, w); break;
+		case 8: sumColumns<numChannels, 8>(sums, out, w); break;
+		default: break;
+	}
+}
+
+
+int ofxImageSequenceVideoScale::getFactor(int width, int height, int targetWidth, int targetHeight){
+	if(targetWidth <= 0 && targetHeight <= 0) return 1;
+	int factor = 1;
+	while(factor < maxFactor){
+		int next = factor * 2;
+		if(targetWidth > 0 && getScaledSize(width, next) < targetWidth) break;
+		if(targetHeight > 0 && getScaledSize(height, next) < targetHeight) break;
+		factor = next;
+	}
+	return factor;
+}
+
+
+void ofxImageSequenceVideoScale::boxDownscale(const ofPixels & src, ofPixels & dst, int factor){
+
+	size_t numChannels = src.getNumChannels();
+	size_t srcWidth = src.getWidth();
+	size_t srcHeight = src.getHeight();
+	size_t w = getScaledSize(srcWidth, factor);
+	size_t h = getScaledSize(srcHeight, factor);
+	dst.allocate(w, h, src.getPixelFormat());
+	if(w == 0 || h == 0) return;
+	size_t numFullCols = srcWidth / factor; //dst pixels made of a whole factor x factor block
+
+	//1st pass sums factor rows into colSums, 2nd pass sums factor columns of that. Both are plain loops over contiguous
+	//memory the compiler vectorizes (no gathers). factor <= 8 means at most 64 * 255 per sum, so 16 bits are enough.
+	size_t srcRowLen = srcWidth * numChannels;
+	size_t dstRowLen = w * numChannels;
+
+	thread_local vector<uint16_t> colSums;
+	colSums.resize(srcRowLen);
+	uint16_t * __restrict sums = colSums.data();
+	const unsigned char * srcData = src.getData();
+	unsigned char * dstData = dst.getData();
+
+	for(size_t y = 0; y < h; y++){
+
+		int numRows = MIN((size_t)factor, srcHeight - y * factor);
+		const unsigned char * __restrict row = srcData + y * factor * srcRowLen;
+		for(size_t i = 0; i < srcRowLen; i++) sums[i] = row[i];
+		for(int r = 1; r < numRows; r++){
+			row += srcRowLen;
+			for(size_t i = 0; i < srcRowLen; i++) sums[i] += row[i];
+		}
+
+		unsigned char * out = dstData + y * dstRowLen;
+		size_t x = 0;
+		if(numRows == factor){
+			switch(numChannels){
+				case 1: sumColumns<1>(sums, out, numFullCols, factor); break;
+				case 2: sumColumns<2>(sums, out, numFullCols, factor); break;
+				case 3: sumColumns<3>(sums, out, numFullCols, factor); break;
+				case 4: sumColumns<4>(sums, out, numFullCols, factor); break;
+				default: break;
+			}
+			x = numFullCols;
+		}
+		for(; x < w; x++){ //partial blocks: the last row, and the last col
+			int numCols = MIN((size_t)factor, srcWidth - x * factor);
+			averageBlock(sums + x * factor * numChannels, out + x * numChannels, numChannels, numCols, numRows);
+		}
+	}
+}
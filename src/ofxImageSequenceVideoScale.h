@@ -0,0 +1,31 @@
+//
+//  ofxImageSequenceVideoScale.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Reduced resolution decoding - see ofxImageSequenceVideo::setTargetResolution().
+//Frames are scaled down by power of 2 factors (1/2, 1/4, 1/8), the same ones libjpeg-turbo can scale by while
+//decoding (in the DCT domain), so all formats of a sequence end up at the same size no matter the decoder.
+//All methods are thread safe.
+class ofxImageSequenceVideoScale{
+
+public:
+
+	static const int maxFactor = 8;
+
+	//largest power of 2 factor (up to maxFactor) that, dividing width x height, still covers targetWidth x targetHeight.
+	//A target of 0 doesn't constrain that dimension; 1 if both are 0 (no scaling).
+	static int getFactor(int width, int height, int targetWidth, int targetHeight);
+
+	//size of a dimension scaled down by factor. Rounds up, as libjpeg-turbo does (TJSCALED): 1921 / 2 is 961
+	static int getScaledSize(int size, int factor){ return (size + factor - 1) / factor; }
+
+	//box filters src into dst (allocated by this, getScaledSize() of src), each dst pixel being the average of a factor x
+	//factor block of src; the last row / col averages the partial blocks at src's edges. 8 bit pixels, 1 to 4 channels;
+	//factor 2, 4 or 8.
+	static void boxDownscale(const ofPixels & src, ofPixels & dst, int factor);
+};
@@ -0,0 +1,186 @@
+//
+//  ofxImageSequenceVideoThreadPool.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+
+ofxImageSequenceVideoThreadPool::ofxImageSequenceVideoThreadPool(int numThreads){
+	for(int i = 0; i < numThreads; i++){
+		workers.emplace_back(&ofxImageSequenceVideoThreadPool::workerLoop, this);
+	}
+}
+
+
+ofxImageSequenceVideoThreadPool::~ofxImageSequenceVideoThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shouldExit = true;
+	}
+	jobAvailable.notify_all();
+	for(auto & t : workers){
+		t.join();
+	}
+}
+
+
+std::shared_ptr<ofxImageSequenceVideoThreadPool> ofxImageSequenceVideoThreadPool::shared(int numThreads){
+	static std::mutex sharedMutex;
+	static std::shared_ptr<ofxImageSequenceVideoThreadPool> pool;
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	if(!pool){
+		if(numThreads <= 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+		pool = std::make_shared<ofxImageSequenceVideoThreadPool>(numThreads);
+	}
+	return pool;
+}
+
+
+double ofxImageSequenceVideoThreadPool::now(){
+	using namespace std::chrono;
+	return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+int ofxImageSequenceVideoThreadPool::addClient(){
+	std::lock_guard<std::mutex> lock(mutex);
+	int clientID = nextClientID++;
+	clients[clientID] = Client();
+	return clientID;
+}
+
+
+void ofxImageSequenceVideoThreadPool::removeClient(int clientID){
+	cancelJobs(clientID);
+	std::lock_guard<std::mutex> lock(mutex);
+	clients.erase(clientID);
+}
+
+
+void ofxImageSequenceVideoThreadPool::submit(int clientID, double deadline, std::function<void()> job){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back({clientID, now() + deadline, std::move(job)});
+		clients[clientID].stats.numQueuedJobs++;
+	}
+	jobAvailable.notify_one();
+}
+
+
+size_t ofxImageSequenceVideoThreadPool::cancelJobs(int clientID){
+	std::vector<Job> cancelled; //destroy them outside the lock, jobs might own heavy state
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(size_t i = 0; i < jobs.size(); ){
+			if(jobs[i].clientID == clientID){
+				cancelled.emplace_back(std::move(jobs[i]));
+				jobs[i] = std::move(jobs.back());
+				jobs.pop_back();
+			}else{
+				i++;
+			}
+		}
+		auto it = clients.find(clientID);
+		if(it != clients.end()) it->second.stats.numQueuedJobs = 0;
+	}
+	jobDone.notify_all();
+	return cancelled.size();
+}
+
+
+void ofxImageSequenceVideoThreadPool::waitForClient(int clientID){
+	std::unique_lock<std::mutex> lock(mutex);
+	jobDone.wait(lock, [this, clientID]{
+		auto it = clients.find(clientID);
+		return it == clients.end() || (it->second.stats.numQueuedJobs == 0 && it->second.stats.numRunningJobs == 0);
+	});
+}
+
+
+size_t ofxImageSequenceVideoThreadPool::getNumQueuedJobs(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size();
+}
+
+
+ofxImageSequenceVideoThreadPool::ClientStats ofxImageSequenceVideoThreadPool::getClientStats(int clientID){
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = clients.find(clientID);
+	if(it != clients.end()) return it->second.stats;
+	return ClientStats();
+}
+
+
+float ofxImageSequenceVideoThreadPool::getClientShare(int clientID){
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = clients.find(clientID);
+	if(it == clients.end() || totalBusySeconds <= 0.0) return 0.0f;
+	return it->second.stats.busySeconds / totalBusySeconds;
+}
+
+
+size_t ofxImageSequenceVideoThreadPool::pickNextJob(){
+
+	auto busySecondsFor = [this](int clientID){
+		auto it = clients.find(clientID);
+		return it != clients.end() ? it->second.stats.busySeconds : 0.0;
+	};
+
+	const double tieThreshold = 0.001; //deadlines closer than 1ms are considered a tie
+	size_t best = 0;
+	double bestBusy = busySecondsFor(jobs[0].clientID);
+	for(size_t i = 1; i < jobs.size(); i++){
+		double busy = busySecondsFor(jobs[i].clientID);
+		double diff = jobs[i].deadline - jobs[best].deadline;
+		if(diff < -tieThreshold || (std::fabs(diff) <= tieThreshold && busy < bestBusy)){
+			best = i;
+			bestBusy = busy;
+		}
+	}
+	return best;
+}
+
+
+void ofxImageSequenceVideoThreadPool::workerLoop(){
+
+	while(true){
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this]{ return shouldExit || !jobs.empty(); });
+			if(jobs.empty()) return; //only get here when exiting and there's no more work to do
+			size_t index = pickNextJob();
+			job = std::move(jobs[index]);
+			jobs.erase(jobs.begin() + index); //keep submission order for equal deadlines
+			auto it = clients.find(job.clientID);
+			if(it != clients.end()){
+				if(it->second.stats.numQueuedJobs > 0) it->second.stats.numQueuedJobs--;
+				it->second.stats.numRunningJobs++;
+			}
+		}
+
+		double t = now();
+		job.run();
+		t = now() - t;
+
+		int clientID = job.clientID;
+		job = Job(); //release whatever the job holds before reporting it as done
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = clients.find(clientID);
+			if(it != clients.end()){
+				it->second.stats.numJobsRun++;
+				it->second.stats.numRunningJobs--;
+				it->second.stats.busySeconds += t;
+			}
+			totalBusySeconds += t;
+		}
+		jobDone.notify_all();
+	}
+}
@@ -0,0 +1,82 @@
+//
+//  ofxImageSequenceVideoThreadPool.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <map>
+
+//Fixed size pool of long-lived worker threads fed through a job queue.
+//Threads are created once on construction and joined on destruction, so submitting
+//work costs a lock + a notify instead of a thread create/join per job.
+//
+//Several clients (players) can share one pool. Each job carries a deadline (the time at
+//which its result will be needed); idle workers always pick the job with the earliest
+//deadline, and break ties in favour of the client that has used the least worker time.
+//This way the player whose buffer is emptiest gets served first, and nobody starves.
+class ofxImageSequenceVideoThreadPool{
+
+public:
+
+	struct ClientStats{
+		uint64_t numJobsRun = 0;
+		double busySeconds = 0.0; //total worker time spent on this client's jobs
+		size_t numQueuedJobs = 0;
+		size_t numRunningJobs = 0;
+	};
+
+	ofxImageSequenceVideoThreadPool(int numThreads);
+	~ofxImageSequenceVideoThreadPool(); //runs all queued jobs, then joins all threads
+
+	//process-wide pool, lazily created with one thread per core (or numThreads if this is
+	//the 1st call and numThreads > 0). Hold on to the shared_ptr to keep it alive.
+	static std::shared_ptr<ofxImageSequenceVideoThreadPool> shared(int numThreads = 0);
+
+	int addClient();
+	void removeClient(int clientID); //drops its queued jobs - caller must wait for its running jobs
+
+	//deadline is in seconds, relative to now(). lower == more urgent
+	void submit(int clientID, double deadline, std::function<void()> job);
+	size_t cancelJobs(int clientID); //drops all queued (not yet running) jobs of that client
+	void waitForClient(int clientID); //blocks until that client has no queued or running jobs
+
+	static double now(); //seconds on a monotonic clock
+
+	int getNumThreads(){ return workers.size(); }
+	size_t getNumQueuedJobs();
+	ClientStats getClientStats(int clientID);
+	float getClientShare(int clientID); //[0..1] fraction of all worker time used by that client
+
+protected:
+
+	struct Job{
+		int clientID;
+		double deadline;
+		std::function<void()> run;
+	};
+
+	struct Client{
+		ClientStats stats;
+	};
+
+	void workerLoop();
+	size_t pickNextJob(); //call with mutex locked and a non-empty queue
+
+	std::vector<std::thread> workers;
+	std::vector<Job> jobs;
+	std::map<int, Client> clients;
+	int nextClientID = 0;
+	double totalBusySeconds = 0.0;
+
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobDone;
+	bool shouldExit = false;
+};
@@ -0,0 +1,400 @@
+//
+//  ofxImageSequenceVideoUringReader.cpp
+//  ofxImageSequenceVideo
+//
+//
+
+#include "ofxImageSequenceVideoUringReader.h"
+
+#if defined(USE_IO_URING) && defined(__linux__)
+	#include <liburing.h>
+	#include <fcntl.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#define ISV_HAS_IO_URING
+#endif
+
+static const size_t directIOAlignment = 4096; //O_DIRECT wants buffers, offsets and lengths aligned to the logical block size
+
+static size_t alignUp(size_t value, size_t alignment){
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+
+ofxImageSequenceVideoUringReader::ofxImageSequenceVideoUringReader(int queueDepth, bool directIO){
+	this->queueDepth = MAX(queueDepth, 2);
+	this->directIO = directIO;
+	bufferPool = std::make_shared<BufferPool>();
+	bufferPool->maxFreeBuffers = this->queueDepth;
+	#if defined(ISV_HAS_IO_URING)
+	io_uring * r = new io_uring();
+	int ret = io_uring_queue_init(this->queueDepth, r, 0);
+	if(ret == 0){
+		ring = r;
+		available = true;
+		thread = std::thread(&ofxImageSequenceVideoUringReader::threadFunction, this);
+	}else{
+		delete r;
+		ofLogWarning("ofxImageSequenceVideo") << "io_uring not available (" << strerror(-ret) << "), falling back to regular reads";
+	}
+	#else
+	ofLogWarning("ofxImageSequenceVideo") << "io_uring support not compiled in, define USE_IO_URING (Linux only). Falling back to regular reads";
+	#endif
+}
+
+
+ofxImageSequenceVideoUringReader::~ofxImageSequenceVideoUringReader(){
+	stop();
+	#if defined(ISV_HAS_IO_URING)
+	if(ring){
+		io_uring_queue_exit((io_uring*)ring);
+		delete (io_uring*)ring;
+		ring = nullptr;
+	}
+	#endif
+}
+
+
+ofxImageSequenceVideoUringReader::BufferPool::~BufferPool(){
+	for(auto & b : freeBuffers){
+		free(b.second);
+	}
+}
+
+
+std::shared_ptr<unsigned char> ofxImageSequenceVideoUringReader::acquireBuffer(size_t size){
+	size_t capacity = alignUp(size, directIOAlignment);
+	unsigned char * buffer = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(bufferPool->mutex);
+		auto & freeBuffers = bufferPool->freeBuffers;
+		for(size_t i = 0; i < freeBuffers.size(); i++){
+			if(freeBuffers[i].first >= capacity){ //frames are roughly the same size, the 1st fit will do
+				capacity = freeBuffers[i].first;
+				buffer = freeBuffers[i].second;
+				freeBuffers.erase(freeBuffers.begin() + i);
+				break;
+			}
+		}
+	}
+	if(!buffer){
+		capacity += capacity / 8; //some slack so that slightly larger frames can reuse it too
+		capacity = alignUp(capacity, directIOAlignment);
+		void * mem = nullptr;
+		if(posix_memalign(&mem, directIOAlignment, capacity) != 0) return nullptr;
+		buffer = (unsigned char*)mem;
+	}
+	std::shared_ptr<BufferPool> pool = bufferPool;
+	return std::shared_ptr<unsigned char>(buffer, [pool, capacity](unsigned char * b){
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		if(pool->freeBuffers.size() < pool->maxFreeBuffers){
+			pool->freeBuffers.emplace_back(capacity, b);
+		}else{
+			free(b);
+		}
+	});
+}
+
+
+void ofxImageSequenceVideoUringReader::read(std::vector<std::unique_ptr<Request>> & requests){
+	if(requests.empty()) return;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!available || stopping) return;
+		for(auto & r : requests){
+			pending.emplace_back(std::move(r));
+		}
+	}
+	requests.clear();
+	requestsAvailable.notify_one();
+}
+
+
+size_t ofxImageSequenceVideoUringReader::cancel(){
+	size_t n;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		n = pending.size();
+		pending.clear();
+	}
+	idle.notify_all();
+	return n;
+}
+
+
+void ofxImageSequenceVideoUringReader::waitUntilIdle(){
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this]{ return pending.empty() && !batchInProgress; });
+}
+
+
+void ofxImageSequenceVideoUringReader::stop(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		pending.clear();
+	}
+	requestsAvailable.notify_all();
+	idle.notify_all();
+	if(thread.joinable()) thread.join();
+}
+
+
+void ofxImageSequenceVideoUringReader::threadFunction(){
+	std::vector<std::unique_ptr<Request>> batch;
+	while(true){
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			requestsAvailable.wait(lock, [this]{ return !pending.empty() || stopping; });
+			if(stopping) break;
+			std::swap(batch, pending); //everything queued since the last batch goes in this one
+			batchInProgress = true;
+		}
+		//each request takes 2 sqes when opening (openat + statx), so that's as many as fit in the ring at once
+		size_t maxChunk = queueDepth / 2;
+		for(size_t i = 0; i < batch.size(); i += maxChunk){
+			std::vector<std::unique_ptr<Request>> chunk;
+			for(size_t j = i; j < MIN(i + maxChunk, batch.size()); j++){
+				chunk.emplace_back(std::move(batch[j]));
+			}
+			processBatch(chunk);
+		}
+		batch.clear();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			batchInProgress = false;
+		}
+		idle.notify_all();
+	}
+}
+
+
+#if defined(ISV_HAS_IO_URING)
+
+//submits all the prepared sqes, and calls onCompletion(userData, result) for each completion. Returns false if the
+//kernel didn't take them all (-EAGAIN, -ENOMEM...): only what was submitted is reaped, the rest never completes and
+//is left in the ring (see resetRing())
+template<typename F>
+static bool submitAndReap(io_uring * ring, int numOps, F onCompletion){
+	if(numOps == 0) return true;
+	int numSubmitted = 0;
+	int numReaped = 0;
+	int numRetries = 0;
+	while(numSubmitted < numOps){
+		int ret = io_uring_submit(ring);
+		if(ret == -EINTR) continue;
+		if(ret > 0){
+			numSubmitted += ret;
+			continue;
+		}
+		//nothing went out - reaping completions frees kernel resources, else retry a few times and give up
+		if(numReaped < numSubmitted){
+			io_uring_cqe * cqe = nullptr;
+			do{
+				ret = io_uring_wait_cqe(ring, &cqe);
+			}while(ret == -EINTR);
+			if(ret < 0) break;
+			onCompletion(io_uring_cqe_get_data64(cqe), cqe->res);
+			io_uring_cqe_seen(ring, cqe);
+			numReaped++;
+		}else if(++numRetries > 3){
+			break;
+		}else{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+	for(; numReaped < numSubmitted; numReaped++){
+		io_uring_cqe * cqe = nullptr;
+		int ret;
+		do{
+			ret = io_uring_wait_cqe(ring, &cqe);
+		}while(ret == -EINTR);
+		if(ret < 0) return false;
+		onCompletion(io_uring_cqe_get_data64(cqe), cqe->res);
+		io_uring_cqe_seen(ring, cqe);
+	}
+	return numSubmitted == numOps;
+}
+
+
+//plain blocking read through the page cache, for when O_DIRECT is not supported by the file system
+//rangeFd: read from it instead of opening path (and leave it open)
+static size_t readBuffered(const string & path, int rangeFd, uint64_t offset, size_t size, unsigned char * dst){
+	int fd = rangeFd >= 0 ? rangeFd : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0) return 0;
+	size_t done = 0;
+	while(done < size){
+		ssize_t n = ::pread(fd, dst + done, size - done, offset + done);
+		if(n < 0 && errno == EINTR) continue;
+		if(n <= 0) break;
+		done += n;
+	}
+	if(fd != rangeFd) ::close(fd);
+	return done;
+}
+
+
+void ofxImageSequenceVideoUringReader::processBatch(std::vector<std::unique_ptr<Request>> & batch){
+
+	io_uring * r = (io_uring*)ring;
+	size_t n = batch.size();
+
+	struct FileState{
+		int fd = -1;
+		bool ownsFd = false; //opened for this request, to be closed at the end
+		bool direct = false;
+		struct statx stx;
+		size_t size = 0;
+		size_t done = 0;
+		bool eof = false;
+		bool failed = false;
+		bool inFlight = false; //an sqe for it is in the ring, waiting for its completion
+	};
+	std::vector<FileState> files(n);
+	int openFlags = O_RDONLY | O_CLOEXEC | (directIO ? O_DIRECT : 0);
+	bool ringOK = !ringBroken;
+
+	//1 - open and stat all the whole-file requests, in a single submission
+	int numOps = 0;
+	for(size_t i = 0; i < n && ringOK; i++){
+		Request & req = *batch[i];
+		FileState & f = files[i];
+		if(req.size > 0){ //range of a file the caller keeps open (ie .isv)
+			bool direct = directIO && req.directFd >= 0 && req.offset % directIOAlignment == 0;
+			f.fd = direct ? req.directFd : req.fd;
+			f.size = req.size;
+			f.direct = direct;
+		}else{
+			io_uring_sqe * sqe = io_uring_get_sqe(r);
+			io_uring_prep_openat(sqe, AT_FDCWD, req.path.c_str(), openFlags, 0);
+			io_uring_sqe_set_data64(sqe, i * 2);
+			sqe = io_uring_get_sqe(r);
+			io_uring_prep_statx(sqe, AT_FDCWD, req.path.c_str(), 0, STATX_SIZE, &f.stx);
+			io_uring_sqe_set_data64(sqe, i * 2 + 1);
+			numOps += 2;
+		}
+	}
+	if(ringOK && !submitAndReap(r, numOps, [&](uint64_t tag, int res){
+		FileState & f = files[tag / 2];
+		if(tag % 2 == 0){ //openat
+			if(res >= 0){
+				f.fd = res;
+				f.ownsFd = true;
+				f.direct = directIO;
+			}else if(res == -EINVAL && directIO){ //file system doesn't do O_DIRECT
+				f.fd = ::open(batch[tag / 2]->path.c_str(), O_RDONLY | O_CLOEXEC);
+				f.ownsFd = f.fd >= 0;
+			}
+		}else if(res == 0){ //statx
+			f.size = f.stx.stx_size;
+		}
+	})){
+		ringOK = resetRing(); //the opens / stats that didn't go out leave their files failed below
+	}
+
+	for(size_t i = 0; i < n; i++){
+		FileState & f = files[i];
+		if(!ringOK || f.fd < 0 || f.size == 0){
+			f.failed = true;
+			continue;
+		}
+		batch[i]->data = acquireBuffer(f.size);
+		if(!batch[i]->data) f.failed = true;
+	}
+
+	//2 - read everything, in a single submission. Reads can come back short, so resubmit the rest until done
+	while(ringOK){
+		numOps = 0;
+		for(size_t i = 0; i < n; i++){
+			FileState & f = files[i];
+			if(f.failed || f.eof || f.done >= f.size) continue;
+			size_t length = f.size - f.done;
+			if(f.direct) length = alignUp(length, directIOAlignment);
+			io_uring_sqe * sqe = io_uring_get_sqe(r);
+			io_uring_prep_read(sqe, f.fd, batch[i]->data.get() + f.done, length, batch[i]->offset + f.done);
+			io_uring_sqe_set_data64(sqe, i);
+			f.inFlight = true;
+			numOps++;
+		}
+		if(numOps == 0) break;
+		bool submitted = submitAndReap(r, numOps, [&](uint64_t i, int res){
+			FileState & f = files[i];
+			f.inFlight = false;
+			if(res > 0){
+				f.done = MIN(f.done + res, f.size); //O_DIRECT lengths are rounded up, we might get more than we asked for
+			}else if(res == 0){
+				f.eof = true;
+			}else if(res == -EINVAL && f.direct){ //O_DIRECT constraints not met, read through the page cache
+				Request & req = *batch[i];
+				f.done += readBuffered(req.path, req.size > 0 ? req.fd : -1, req.offset + f.done, f.size - f.done, req.data.get() + f.done);
+				f.eof = true;
+			}else{
+				f.failed = true;
+			}
+		});
+		if(!submitted){ //reads that never went out fail, the ones that did are done
+			for(auto & f : files){
+				if(f.inFlight) f.failed = true;
+			}
+			ringOK = resetRing();
+		}
+	}
+
+	//3 - close the files we opened
+	numOps = 0;
+	for(size_t i = 0; i < n && ringOK; i++){
+		if(files[i].ownsFd){
+			io_uring_sqe * sqe = io_uring_get_sqe(r);
+			io_uring_prep_close(sqe, files[i].fd);
+			io_uring_sqe_set_data64(sqe, i);
+			files[i].inFlight = true;
+			numOps++;
+		}
+	}
+	if(ringOK && !submitAndReap(r, numOps, [&](uint64_t i, int){ files[i].inFlight = false; })){
+		resetRing();
+	}
+	for(auto & f : files){ //whatever the ring didn't close
+		if(f.ownsFd && (!ringOK || f.inFlight)) ::close(f.fd);
+	}
+
+	numBatches++;
+	numReads += n;
+	for(size_t i = 0; i < n; i++){
+		Request & req = *batch[i];
+		req.bytesRead = files[i].done;
+		req.ok = !files[i].failed && files[i].done == files[i].size;
+		if(!req.ok){
+			ofLogError("ofxImageSequenceVideo") << "io_uring can't read \"" << req.path << "\"";
+		}
+		if(req.onDone) req.onDone(req);
+	}
+}
+
+#else
+
+void ofxImageSequenceVideoUringReader::processBatch(std::vector<std::unique_ptr<Request>> &){
+	//never called, the reader is not available without io_uring
+}
+
+#endif
+
+
+bool ofxImageSequenceVideoUringReader::resetRing(){
+	#if defined(ISV_HAS_IO_URING)
+	//everything submitted has been reaped; what's left in the submission queue never went out, and would go out with
+	//the next submission (reading into buffers that are gone by then). A fresh ring is the only way to drop it
+	io_uring * r = (io_uring*)ring;
+	io_uring_queue_exit(r);
+	int ret = io_uring_queue_init(queueDepth, r, 0);
+	if(ret != 0){
+		delete r;
+		ring = nullptr;
+		ringBroken = true;
+		ofLogError("ofxImageSequenceVideo") << "io_uring submission failed and the ring can't be reset (" << strerror(-ret) << "), all reads will fail";
+		return false;
+	}
+	ofLogWarning("ofxImageSequenceVideo") << "io_uring submission failed, reset the ring";
+	#endif
+	return !ringBroken;
+}
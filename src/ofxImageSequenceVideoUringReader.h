@@ -0,0 +1,85 @@
+//
+//  ofxImageSequenceVideoUringReader.h
+//  ofxImageSequenceVideo
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+//Batched async file reader on top of Linux's io_uring. Needs liburing: define USE_IO_URING in your pre-processor
+//macros and link with -luring. Without it (or if the kernel doesn't support io_uring) isAvailable() returns false.
+//
+//A single ring thread takes all the requests queued since its last batch and opens all the files, then reads all
+//of them, then closes them; each step is one io_uring submission. The drive gets all the reads at once (deep queue),
+//and a batch costs a handful of syscalls instead of an open/fstat/read/close per frame.
+//With directIO, files are opened with O_DIRECT to bypass the page cache, so sequences much larger than RAM don't
+//thrash it (and don't evict everything else). Files that don't support it are read through the page cache.
+class ofxImageSequenceVideoUringReader{
+
+public:
+
+	struct Request{
+		string path;
+		uint64_t offset = 0;
+		size_t size = 0; //0 reads the whole file
+		//ranges (size > 0) are read from these fds, owned by the caller; they must stay open until onDone()
+		int fd = -1;
+		int directFd = -1; //optional, the same file opened with O_DIRECT; used in directIO mode
+		std::function<void(Request &)> onDone; //called on the ring thread when the read is done (or failed)
+
+		//results, valid in onDone()
+		bool ok = false;
+		std::shared_ptr<unsigned char> data; //page aligned buffer, holds bytesRead bytes
+		size_t bytesRead = 0;
+	};
+
+	ofxImageSequenceVideoUringReader(int queueDepth = 32, bool directIO = false);
+	~ofxImageSequenceVideoUringReader();
+
+	bool isAvailable(){ return available; }
+	bool getDirectIO(){ return directIO; }
+
+	void read(std::vector<std::unique_ptr<Request>> & requests); //queues a batch of reads, takes ownership of them
+	size_t cancel(); //drops the requests not started yet (their onDone() is never called), returns how many
+	void waitUntilIdle(); //blocks until all queued requests are done
+	void stop(); //cancel() and wait for the batch in progress to finish. No more reads after this
+
+	uint64_t getNumBatches(){ return numBatches; }
+	uint64_t getNumReads(){ return numReads; }
+	float getAvgBatchSize(){ return numBatches ? numReads / float(numBatches) : 0.0f; }
+
+protected:
+
+	void threadFunction();
+	void processBatch(std::vector<std::unique_ptr<Request>> & batch);
+	bool resetRing(); //drops any sqes a failed submission left in the ring. Ring thread only
+
+	bool available = false;
+	bool directIO = false;
+	int queueDepth = 32;
+
+	void * ring = nullptr; //struct io_uring *, kept opaque so that this header doesn't need liburing
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable requestsAvailable;
+	std::condition_variable idle;
+	std::vector<std::unique_ptr<Request>> pending;
+	bool batchInProgress = false;
+	bool stopping = false;
+	bool ringBroken = false; //couldn't be reset after a failed submission, all reads fail from then on. Ring thread only
+
+	//read buffers are recycled (as the pixel buffers are, see ofxImageSequenceVideoPixelPool), fresh multi-Mb buffers cost
+	//a page fault per 4Kb page on first touch. Shared with the buffers' deleters, as those can outlive the reader
+	struct BufferPool{
+		std::mutex mutex;
+		std::vector<std::pair<size_t, unsigned char*>> freeBuffers; //capacity, buffer
+		size_t maxFreeBuffers = 0;
+		~BufferPool();
+	};
+	std::shared_ptr<BufferPool> bufferPool;
+	std::shared_ptr<unsigned char> acquireBuffer(size_t size); //page aligned
+
+	std::atomic<uint64_t> numBatches{0};
+	std::atomic<uint64_t> numReads{0};
+};
@@ -0,0 +1,351 @@
+//
+//  isvBench - microbenchmarks for ofxImageSequenceVideo's worker side stages
+//
+//  usage: isvBench convert [numIterations]
+//         isvBench jpeg [numIterations] <file.jpg>...   (USE_TURBO_JPEG builds)
+//         isvBench decode [numIterations] <imageFile>...
+//         isvBench dxt [numIterations] <dxtSequenceDir>
+//         isvBench threads [numIterations] <imageFile>...
+//
+
+#include "ofMain.h"
+#include "ofxImageSequenceVideo.h"
+#include <future>
+#if defined(TARGET_LINUX)
+	#include <unistd.h>
+#endif
+#if defined(USE_TURBO_JPEG)
+	#include "turbojpeg.h"
+#endif
+
+typedef ofxImageSequenceVideoPixelConvert Convert;
+
+//times each pixel format conversion kernel with each instruction set this cpu has, at 1080p and 4K
+static void benchConvert(int numIterations){
+
+	struct Kernel{
+		string name;
+		size_t srcChannels, dstChannels;
+		void (*func)(const unsigned char *, unsigned char *, size_t, Convert::Isa);
+	};
+	vector<Kernel> kernels = {
+		{"RGB->RGBA", 3, 4, Convert::rgbToRgba},
+		{"RGB->BGRA", 3, 4, Convert::rgbToBgra},
+		{"RGBA->RGB", 4, 3, Convert::rgbaToRgb},
+		{"RGBA->BGRA", 4, 4, Convert::rgbaToBgra},
+	};
+	struct Size{ string name; size_t width, height; };
+	vector<Size> sizes = {{"1080p", 1920, 1080}, {"4K", 3840, 2160}};
+	vector<Convert::Isa> isas = {Convert::SCALAR, Convert::SSSE3, Convert::AVX2, Convert::NEON};
+
+	std::cout << "best instruction set: " << Convert::getIsaName(Convert::AUTO) << std::endl;
+	for(auto & size : sizes){
+		size_t numPixels = size.width * size.height;
+		vector<unsigned char> src(numPixels * 4, 128);
+		vector<unsigned char> dst(numPixels * 4);
+		for(auto & k : kernels){
+			float scalarMs = 0;
+			for(auto isa : isas){
+				if(!Convert::isIsaAvailable(isa)) continue;
+				k.func(src.data(), dst.data(), numPixels, isa); //warm up
+				uint64_t t = ofGetElapsedTimeMicros();
+				for(int i = 0; i < numIterations; i++){
+					k.func(src.data(), dst.data(), numPixels, isa);
+				}
+				float ms = (ofGetElapsedTimeMicros() - t) / (1000.0f * numIterations);
+				if(isa == Convert::SCALAR) scalarMs = ms;
+				float gbs = numPixels * (k.srcChannels + k.dstChannels) / (ms * 1000000.0f);
+				std::cout << size.name << "\t" << k.name << "\t" << Convert::getIsaName(isa) << "\t" << ofToString(ms, 3) << " ms\t"
+						  << ofToString(gbs, 2) << " GB/s\tx" << ofToString(scalarMs / ms, 2) << std::endl;
+			}
+		}
+	}
+}
+
+#if defined(USE_TURBO_JPEG)
+//per frame decode time of each jpg with a decompressor created per frame (as the player did before) vs a reused one
+//(as its worker threads do now), and what fraction of a 60fps frame that is. Decodes from memory, no disk involved.
+static void benchJpeg(const vector<string> & files, int numIterations){
+
+	for(auto & file : files){
+		ofBuffer buffer = ofBufferFromFile(file, true);
+		const unsigned char * data = (const unsigned char *)buffer.getData();
+		unsigned long size = buffer.size();
+
+		tjhandle reused = tjInitDecompress();
+		int w, h, subsamp, colorspace;
+		if(size == 0 || tjDecompressHeader3(reused, data, size, &w, &h, &subsamp, &colorspace) != 0){
+			std::cerr << "can't read \"" << file << "\"" << std::endl;
+			tjDestroy(reused);
+			continue;
+		}
+		vector<unsigned char> pixels((size_t)w * h * 3);
+		auto decode = [&](tjhandle decoder){
+			tjDecompress2(decoder, data, size, pixels.data(), w, 0, h, TJPF_RGB, TJFLAG_FASTDCT);
+		};
+
+		decode(reused); //warm up
+		uint64_t t = ofGetElapsedTimeMicros();
+		for(int i = 0; i < numIterations; i++){
+			tjhandle decoder = tjInitDecompress();
+			decode(decoder);
+			tjDestroy(decoder);
+		}
+		float perFrameMs = (ofGetElapsedTimeMicros() - t) / (1000.0f * numIterations);
+
+		t = ofGetElapsedTimeMicros();
+		for(int i = 0; i < numIterations; i++){
+			decode(reused);
+		}
+		float reusedMs = (ofGetElapsedTimeMicros() - t) / (1000.0f * numIterations);
+		tjDestroy(reused);
+
+		float frameMs = 1000.0f / 60.0f;
+		std::cout << ofFilePath::getFileName(file) << " (" << w << " x " << h << ")\n"
+				  << "\tnew decompressor per frame: " << ofToString(perFrameMs, 3) << " ms (" << ofToString(100 * perFrameMs / frameMs, 1) << "% of a 60fps frame)\n"
+				  << "\treused decompressor:        " << ofToString(reusedMs, 3) << " ms (" << ofToString(100 * reusedMs / frameMs, 1) << "% of a 60fps frame)"
+				  << std::endl;
+	}
+}
+#endif
+
+//per frame decode time of each file with each decoder backend that can decode it, to pick the fastest one for a
+//sequence (see ofxImageSequenceVideo::setDecoder()). Decodes from memory through the player's own decode path.
+static void benchDecode(const vector<string> & files, int numIterations){
+
+	typedef ofxImageSequenceVideo::Decoder Decoder;
+	vector<Decoder> decoders = {Decoder::FREEIMAGE, Decoder::STB};
+	#if defined(USE_TURBO_JPEG)
+	decoders.push_back(Decoder::TURBOJPEG);
+	#endif
+
+	ofxImageSequenceVideo player;
+	ofPixels pixels;
+	for(auto & file : files){
+		ofBuffer buffer = ofBufferFromFile(file, true);
+		if(buffer.size() == 0){
+			std::cerr << "can't read \"" << file << "\"" << std::endl;
+			continue;
+		}
+		const unsigned char * data = (const unsigned char *)buffer.getData();
+		string ext = ofFilePath::getFileExt(file);
+		std::cout << ofFilePath::getFileName(file) << " (" << ofToString(buffer.size() / 1024.0f, 1) << " Kb)" << std::endl;
+
+		for(auto d : decoders){
+			player.setDecoder(d);
+			if(player.getDecoderFor(ext) != d) continue; //it can't decode this format, it would fall back to FreeImage
+			bool ok = player.decodeImage(ext, data, buffer.size(), pixels); //warm up
+			uint64_t t = ofGetElapsedTimeMicros();
+			for(int i = 0; ok && i < numIterations; i++){
+				ok = player.decodeImage(ext, data, buffer.size(), pixels);
+			}
+			float ms = (ofGetElapsedTimeMicros() - t) / (1000.0f * numIterations);
+			std::cout << "\t" << ofxImageSequenceVideo::getDecoderName(d) << ":\t" << (ok ? ofToString(ms, 3) + " ms" : string("failed"))
+					  << "\t" << pixels.getWidth() << " x " << pixels.getHeight() << " x " << pixels.getNumChannels() << std::endl;
+		}
+	}
+}
+
+//decoded frames per second with the worker thread pool the player uses (resident threads, see
+//ofxImageSequenceVideoThreadPool) vs a std::async() thread per frame (as it did before), for each file and decoder
+//backend. Both keep one decode per core in flight (as the player keeps its buffer full), until numIterations frames are
+//decoded, and check for finished ones as often. Each decodes into a thread_local ofPixels, as the workers do: pool
+//threads reuse theirs (and their decoder state), each std::async() thread starts from scratch.
+static void benchThreads(const vector<string> & files, int numIterations){
+
+	typedef ofxImageSequenceVideo::Decoder Decoder;
+	vector<Decoder> decoders = {Decoder::FREEIMAGE, Decoder::STB};
+	#if defined(USE_TURBO_JPEG)
+	decoders.push_back(Decoder::TURBOJPEG);
+	#endif
+	int numThreads = MAX(1, (int)std::thread::hardware_concurrency());
+	std::cout << numThreads << " decodes in flight, " << numIterations << " frames per run" << std::endl;
+
+	ofxImageSequenceVideo player;
+	for(auto & file : files){
+		ofBuffer buffer = ofBufferFromFile(file, true);
+		if(buffer.size() == 0){
+			std::cerr << "can't read \"" << file << "\"" << std::endl;
+			continue;
+		}
+		const unsigned char * data = (const unsigned char *)buffer.getData();
+		size_t size = buffer.size();
+		string ext = ofFilePath::getFileExt(file);
+		std::cout << ofFilePath::getFileName(file) << " (" << ofToString(size / 1024.0f, 1) << " Kb)" << std::endl;
+
+		for(auto d : decoders){
+			player.setDecoder(d);
+			if(player.getDecoderFor(ext) != d) continue; //it can't decode this format, it would fall back to FreeImage
+			ofPixels pixels;
+			if(!player.decodeImage(ext, data, size, pixels)){
+				std::cout << "\t" << ofxImageSequenceVideo::getDecoderName(d) << ":\tfailed" << std::endl;
+				continue;
+			}
+
+			std::atomic<int> numDone{0};
+			auto decode = [&](){
+				thread_local ofPixels threadPixels;
+				player.decodeImage(ext, data, size, threadPixels);
+				numDone++;
+			};
+			auto waitABit = [](){ std::this_thread::sleep_for(std::chrono::microseconds(100)); };
+
+			numDone = 0;
+			uint64_t t = ofGetElapsedTimeMicros();
+			{
+				ofxImageSequenceVideoThreadPool pool(numThreads); //threads are created once, before the clock runs in the player
+				int clientID = pool.addClient();
+				t = ofGetElapsedTimeMicros();
+				for(int numLaunched = 0; numDone < numIterations; waitABit()){
+					for(; numLaunched < numIterations && numLaunched - numDone < numThreads; numLaunched++){
+						pool.submit(clientID, 0, decode);
+					}
+				}
+				pool.removeClient(clientID);
+			}
+			float poolFps = numIterations / ((ofGetElapsedTimeMicros() - t) / 1000000.0f);
+
+			numDone = 0;
+			t = ofGetElapsedTimeMicros();
+			vector<std::future<void>> tasks;
+			for(int numLaunched = 0; numDone < numIterations; waitABit()){
+				for(; numLaunched < numIterations && (int)tasks.size() < numThreads; numLaunched++){
+					tasks.push_back(std::async(std::launch::async, decode));
+				}
+				for(auto it = tasks.begin(); it != tasks.end();){
+					if(it->wait_for(std::chrono::microseconds(0)) == std::future_status::ready){
+						it = tasks.erase(it);
+					}else{
+						++it;
+					}
+				}
+			}
+			float asyncFps = numIterations / ((ofGetElapsedTimeMicros() - t) / 1000000.0f);
+
+			std::cout << "\t" << ofxImageSequenceVideo::getDecoderName(d) << ":\t" << pixels.getWidth() << " x " << pixels.getHeight()
+					  << "\tpool: " << ofToString(poolFps, 1) << " fps\tstd::async: " << ofToString(asyncFps, 1) << " fps\tx"
+					  << ofToString(poolFps / asyncFps, 2) << std::endl;
+		}
+	}
+}
+
+static size_t getRssKb(){
+	#if defined(TARGET_LINUX)
+	std::ifstream statm("/proc/self/statm");
+	size_t size = 0, resident = 0;
+	statm >> size >> resident;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+	#else
+	return 0;
+	#endif
+}
+
+//per frame load time of a DXT sequence (ie 4K DXT5) through ofxDXT::loadFromDisk() into a new ofxDXT::Data (as the
+//player loads loose .dxt files) vs as views into a mapped .isv pack of it (as it loads packed ones: readahead hint for
+//the next frame, fault the frame's pages in, drop the previous one's). numIterations frames are loaded, cycling over
+//the sequence, after a warm up pass; the page cache is warm for both. The GL upload is the same for both, not timed
+static void benchDXT(const string & dir, int numIterations){
+
+	vector<string> fileNames = ofxImageSequenceVideo::getImagesAtDirectory(dir, true);
+	if(fileNames.empty()){
+		std::cerr << "no .dxt files in \"" << dir << "\"" << std::endl;
+		return;
+	}
+	string isvPath = (std::filesystem::temp_directory_path() / "isvBench-dxt.isv").string();
+	ofxImageSequenceVideoPackedFile packed;
+	if(!ofxImageSequenceVideo::packImageSequence(dir, isvPath) || !packed.open(isvPath)){
+		std::cerr << "can't pack \"" << dir << "\"" << std::endl;
+		return;
+	}
+	int numFrames = packed.getNumFrames();
+	auto & e = packed.getEntry(0);
+	string type = packed.getDXTCompressionType() == ofxDXT::DXT1 ? "DXT1" : packed.getDXTCompressionType() == ofxDXT::DXT3 ? "DXT3" : "DXT5";
+	std::cout << numFrames << " frames, " << e.width << " x " << e.height << " " << type << ", "
+			  << ofToString(e.size / (1024.0f * 1024.0f), 2) << " MB per frame" << (packed.isMapped() ? "" : " (can't map the .isv!)") << std::endl;
+
+	volatile unsigned char sink = 0;
+	auto copyPath = [&](int frame){
+		ofxDXT::Data data;
+		ofxDXT::loadFromDisk(dir + "/" + fileNames[frame % numFrames], data);
+		sink += data.size() ? data.getData()[data.size() - 1] : 0;
+	};
+	auto viewPath = [&](int frame){
+		int f = frame % numFrames;
+		packed.willNeed((f + 1) % numFrames);
+		packed.touchFrame(f);
+		const unsigned char * view = packed.getFrameData(f);
+		sink += view ? view[packed.getEntry(f).size - 1] : 0;
+		packed.dontNeed((f + numFrames - 1) % numFrames);
+	};
+
+	auto run = [&](const string & name, std::function<void(int)> load){
+		for(int i = 0; i < numFrames; i++) load(i); //warm up
+		size_t rss = getRssKb();
+		uint64_t t = ofGetElapsedTimeMicros();
+		for(int i = 0; i < numIterations; i++) load(i);
+		float ms = (ofGetElapsedTimeMicros() - t) / (1000.0f * numIterations);
+		std::cout << "\t" << name << ofToString(ms, 3) << " ms/frame\t" << ofToString(1000.0f / ms, 1) << " fps\t"
+				  << ofToString(e.size / (ms * 1000000.0f), 2) << " GB/s\tRSS " << ofToString(((int64_t)getRssKb() - (int64_t)rss) / 1024.0f, 1)
+				  << " MB" << std::endl;
+	};
+	run("ofxDXT::loadFromDisk():  ", copyPath);
+	run("mapped .isv views:       ", viewPath);
+
+	packed.close();
+	std::error_code err;
+	std::filesystem::remove(isvPath, err);
+}
+
+//========================================================================
+int main(int argc, char ** argv){
+
+	string usage = "usage: isvBench convert [numIterations]\n"
+				   "       isvBench jpeg [numIterations] <file.jpg>...\n"
+				   "       isvBench decode [numIterations] <imageFile>...\n"
+				   "       isvBench dxt [numIterations] <dxtSequenceDir>\n"
+				   "       isvBench threads [numIterations] <imageFile>...";
+	if(argc < 2){
+		std::cerr << usage << std::endl;
+		return 1;
+	}
+	string bench = argv[1];
+	int numIterations = 50;
+	int firstArg = 2; //the optional iteration count goes right after the benchmark name
+	if(argc > 2 && string(argv[2]).find_first_not_of("0123456789") == string::npos){
+		numIterations = MAX(1, atoi(argv[2]));
+		firstArg = 3;
+	}
+
+	if(bench == "convert"){
+		benchConvert(numIterations);
+	}else if(bench == "decode"){
+		vector<string> files;
+		for(int i = firstArg; i < argc; i++){
+			files.push_back(std::filesystem::absolute(argv[i]).string());
+		}
+		benchDecode(files, numIterations);
+	}else if(bench == "threads"){
+		vector<string> files;
+		for(int i = firstArg; i < argc; i++){
+			files.push_back(std::filesystem::absolute(argv[i]).string());
+		}
+		benchThreads(files, numIterations);
+	}else if(bench == "dxt" && argc > firstArg){
+		benchDXT(std::filesystem::absolute(argv[firstArg]).string(), numIterations);
+	}else if(bench == "jpeg"){
+		#if defined(USE_TURBO_JPEG)
+		vector<string> files;
+		for(int i = firstArg; i < argc; i++){
+			files.push_back(std::filesystem::absolute(argv[i]).string());
+		}
+		benchJpeg(files, numIterations);
+		#else
+		std::cerr << "isvBench was built without USE_TURBO_JPEG" << std::endl;
+		return 1;
+		#endif
+	}else{
+		std::cerr << usage << std::endl;
+		return 1;
+	}
+	return 0;
+}
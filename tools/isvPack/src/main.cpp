@@ -0,0 +1,24 @@
+//
+//  isvPack - packs a directory of images into a single .isv file for ofxImageSequenceVideo
+//
+//  usage: isvPack <imageSequenceDir> <output.isv>
+//
+
+#include "ofMain.h"
+#include "ofxImageSequenceVideo.h"
+
+//========================================================================
+int main(int argc, char ** argv){
+
+	if(argc != 3){
+		std::cerr << "usage: isvPack <imageSequenceDir> <output.isv>" << std::endl;
+		return 1;
+	}
+
+	//work with absolute paths, so that they are not resolved relative to the data folder
+	string dir = std::filesystem::absolute(argv[1]).string();
+	string out = std::filesystem::absolute(argv[2]).string();
+
+	bool ok = ofxImageSequenceVideo::packImageSequence(dir, out);
+	return ok ? 0 : 1;
+}
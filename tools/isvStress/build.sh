@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+#  builds isvStress against the openFrameworks stub in stub/ - no openFrameworks install needed
+#
+#  usage: ./build.sh [address|thread|none] [extra compiler flags]
+#         ie: ./build.sh thread && ./isvStress reload 15 pipeline
+#
+#  address (default) builds with AddressSanitizer + UndefinedBehaviorSanitizer, thread with ThreadSanitizer, none
+#  without sanitizers (AddressSanitizer holds on to freed memory for a while, so the RSS it reports is only meaningful
+#  with none).
+#  Pass -DUSE_IO_URING -luring as extra flags to test the io_uring reader (needs liburing).
+#
+
+cd "$(dirname "$0")" || exit 1
+sanitizer=${1:-address}
+[ $# -gt 0 ] && shift
+
+case $sanitizer in
+	address) flags="-fsanitize=address,undefined -fno-omit-frame-pointer" ;;
+	thread) flags="-fsanitize=thread" ;;
+	none) flags="" ;;
+	*) echo "unknown sanitizer: $sanitizer"; exit 1 ;;
+esac
+
+${CXX:-g++} -std=c++17 -O1 -g $flags -DOFX_IMAGE_SEQUENCE_VIDEO__STB_IMAGE_IMPLEMENTATION \
+	-Istub -I../../src -I../../lib src/main.cpp ../../src/*.cpp -o isvStress -lpthread "$@"
@@ -0,0 +1,613 @@
+//
+//  isvStress - stress tests for ofxImageSequenceVideo's threading, to be run under the sanitizers (see build.sh)
+//
+//  usage: isvStress reload [seconds] [threads|pipeline|shared|uring|immediate|dxt] [seed]
+//         isvStress seek [seconds] [threads|pipeline|shared|uring|dxt] [seed]
+//         isvStress soak [seconds] [threads|pipeline|shared|uring]
+//         isvStress update [seconds] [threads|pipeline|shared|uring]
+//
+//  reload: plays while reloading (loadImageSequence(), queueNextSequence(), setPlaylist()) a few hundred times a
+//  second, between directories, a pattern with missing and broken frames, an .isv and a chunked sequence, seeking
+//  and changing speed along the way. Checks that the pixels on screen are always the current frame's, and that
+//  once playback settles, no frame table other than the current (and queued) one is still alive.
+//
+//  seek: plays a long sequence while seeking at random (seekToFrame(), setPosition(), advanceOneFrame()), flipping
+//  direction and speed, pausing and with jittery update times, so frames keep being evicted while workers load them.
+//  Checks that every frame whose pixels were handed to the main thread holds its own tag, and once paused and
+//  settled, that no frame is left LOADING / DISREGARDED and the buffer is full. Meant for ./build.sh thread
+//
+//  update: main thread cost of 1, 4, 16 and 64 players playing at once, at 60 fps (seconds / 4 each). Times each
+//  player's update(), and on its own the part of it that collects the finished loads (handleThreadCleanup()), and
+//  prints the average and 99th percentile per call, the loads collected per second and the main thread time all
+//  players take per 60 fps frame. Meant for ./build.sh none
+//
+//  dxt mode: worker threads playing DXT sequences, a directory of .dxt files (through ofxDXT::Data) and .isv packs of
+//  them (views into the mapped file); the checks look at the frames' compressed blocks instead of their pixels.
+//
+//  soak: plain looping playback of 1080p frames, with an output pixel format set (the decoder's own, so the post decode
+//  stage has nothing to do) and a 128 MB RAM budget. Prints pixel buffer allocations / recycled buffers per second,
+//  buffer length, RAM use and RSS, once a second. Fails if decoded frame buffers are still being allocated once playback
+//  is warm, or if RAM use goes over budget. Meant for ./build.sh none
+//
+//  Builds against the openFrameworks stub in stub/, whose fake decoder fills a frame's pixels with a tag read from
+//  its file (and whose ofxDXT keeps it as the 1st bytes of the blocks); test sequences are generated in a temp
+//  directory. Exits with 1 if a check fails.
+//
+
+#include "ofMain.h"
+#include "ofxImageSequenceVideo.h"
+#if defined(__linux__)
+	#include <unistd.h>
+#endif
+
+//player with access to its internals, to check on them between update() calls
+class CheckedPlayer : public ofxImageSequenceVideo{
+public:
+
+	//keeps an eye on every frame table the player has had; call after anything that might have created one
+	void trackTables(){
+		if(frameTable) track(frameTable);
+		if(nextSequence) track(nextSequence->table);
+	}
+	int getNumLiveTables(){
+		int n = 0;
+		for(auto it = tables.begin(); it != tables.end();){
+			if(it->second.expired()){
+				it = tables.erase(it);
+			}else{
+				n++; ++it;
+			}
+		}
+		return n;
+	}
+	//tables still alive that are neither the current nor the queued sequence's
+	int getNumStaleTables(){
+		int n = 0;
+		for(auto & t : tables){
+			auto table = t.second.lock();
+			if(table && table != frameTable && !(nextSequence && table == nextSequence->table)) n++;
+		}
+		return n;
+	}
+
+	//async mode: if the current frame's pixels are ready, they must hold its tag (and not some other frame's,
+	//or another sequence's). Returns false and fills error if they don't
+	bool checkCurrentPixels(string & error){
+		if(!loaded || numThreads == 0) return true;
+		return checkFramePixels(currentFrame, error);
+	}
+	//same, for all the frames whose pixels the main thread owns
+	bool checkAllPixels(string & error){
+		if(!loaded || numThreads == 0) return true;
+		for(int i = 0; i < numFrames; i++){
+			if(!checkFramePixels(i, error)) return false;
+		}
+		return true;
+	}
+
+	//async mode, after a while with no playback nor seeks: all tasks done, nothing left half way through the state
+	//machine, and the buffer window loaded
+	bool checkSettled(string & error){
+		if(!loaded || numThreads == 0) return true;
+		if(numTasksInFlight != 0){
+			error = ofToString(numTasksInFlight) + " tasks still in flight";
+			return false;
+		}
+		for(int i = 0; i < numFrames; i++){
+			PixelState state = frameTable->pixState[i];
+			if(state == PixelState::LOADING || state == PixelState::DISREGARDED){
+				error = "frame " + ofToString(i) + " is stuck " + (state == PixelState::LOADING ? "LOADING" : "DISREGARDED");
+				return false;
+			}
+		}
+		for(int frame : bufferWindow){
+			PixelState state = frameTable->pixState[frame];
+			if(state != PixelState::THREAD_FINISHED_LOADING && state != PixelState::LOADED && state != PixelState::FAILED &&
+			   frameTable->texState[frame] != TextureState::LOADED && !isFrameMissing(frame)){
+				error = "frame " + ofToString(frame) + " is in the buffer window but not loaded";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//collects the finished loads right away, as update() does, so that can be timed on its own; update() then finds
+	//(almost) nothing left to collect. Returns how many there were
+	int collectFinishedLoads(){
+		int n = numTasksInFlight;
+		handleThreadCleanup();
+		return n - numTasksInFlight;
+	}
+
+	int getNumChecks(){ return numChecks; }
+	uint64_t getNumPixelAllocations(){ return pixelPool.getNumAllocations(); }
+	uint64_t getNumPixelReuses(){ return pixelPool.getNumReuses(); }
+
+	static int getTag(const unsigned char * bytes){ return (bytes[0] << 16) | (bytes[1] << 8) | bytes[2]; }
+
+protected:
+
+	void track(const std::shared_ptr<FrameTable> & table){
+		tables.emplace(table->generation, table);
+	}
+
+	bool checkFramePixels(int frame, string & error){
+		PixelState state = frameTable->pixState[frame]; //acquire, the pixels are ours if it's one of these
+		if(state != PixelState::THREAD_FINISHED_LOADING && state != PixelState::LOADED) return true;
+
+		FrameData & d = *frameTable->data[frame];
+		const unsigned char * bytes = d.pixels.getData();
+		size_t size = d.pixels.size();
+		if(useDXTCompression){
+			bytes = d.compressedView.isSet() ? d.compressedView.data : d.compressedPixels.getData();
+			size = d.compressedView.isSet() ? d.compressedView.size : d.compressedPixels.size();
+		}
+		int got = size >= 3 ? getTag(bytes) : -1;
+		int expected = getFrameTag(frame);
+		numChecks++;
+		if(got != expected){
+			error = "frame " + ofToString(frame) + " of \"" + imgSequencePath + "\" (generation " +
+					ofToString(frameTable->generation) + ") holds tag " + ofToString(got) + ", expected " + ofToString(expected);
+			return false;
+		}
+		return true;
+	}
+
+	int getFrameTag(int frame){ //straight from the frame's file, as the player sees it. Cached for the current table
+		if(tagsGeneration != frameTable->generation || tags.size() != (size_t)numFrames){
+			tagsGeneration = frameTable->generation;
+			tags.assign(numFrames, -2);
+		}
+		if(tags[frame] == -2){
+			ofBuffer bytes;
+			size_t offset = 0;
+			if(packedFile){
+				packedFile->readFrame(frame, bytes);
+			}else{
+				bytes = ofBufferFromFile(getFramePath(framePattern.get(), *frameTable, frame), true);
+				if(useDXTCompression) offset = 12; //the stub .dxt header
+			}
+			tags[frame] = bytes.size() >= offset + 3 ? getTag((const unsigned char *)bytes.getData() + offset) : -1;
+		}
+		return tags[frame];
+	}
+
+	std::map<uint32_t, std::weak_ptr<FrameTable>> tables; //by generation
+	vector<int> tags; //-1 can't be decoded, -2 not read yet
+	uint32_t tagsGeneration = 0;
+	int numChecks = 0;
+};
+
+//test sequences - each frame file holds a tag unique across all of them
+struct TestData{
+
+	string root;
+	string dirA, dirB, isv, pattern, chunkRoot, longDir;
+	string dxtDir, dxtIsv, dxtLongIsv;
+	vector<string> chunks;
+	int patternFirst = 1, patternLast = 80;
+
+	bool create(){
+		root = (std::filesystem::temp_directory_path() / ("isvStress-" + ofToString(getpid()))).string();
+		std::filesystem::create_directories(root);
+
+		dirA = root + "/a";
+		writeFrames(dirA, "a_%04d.jpg", 0, 60);
+		dirB = root + "/b";
+		writeFrames(dirB, "b_%04d.png", 0, 45);
+		isv = root + "/a.isv";
+		if(!ofxImageSequenceVideo::packImageSequence(dirA, isv)) return false;
+
+		//every 7th frame missing, and one that can't be decoded
+		pattern = root + "/c/shot_%05d.jpg";
+		std::filesystem::create_directories(root + "/c");
+		for(int i = patternFirst; i <= patternLast; i++){
+			if(i % 7 == 0) continue;
+			writeFrame(formatPath(pattern, i), i != 33);
+		}
+
+		chunkRoot = root + "/reel";
+		for(int i = 0; i < 3; i++){
+			chunks.push_back(chunkRoot + "/000" + ofToString(i));
+			writeFrames(chunks.back(), "r_%04d.jpg", i * 20, 20);
+		}
+
+		longDir = root + "/long";
+		writeFrames(longDir, "l_%05d.jpg", 0, 500);
+
+		dxtDir = root + "/dxt";
+		writeDXTFrames(dxtDir, "d_%04d.dxt", 0, 60);
+		dxtIsv = root + "/dxt.isv";
+		if(!ofxImageSequenceVideo::packImageSequence(dxtDir, dxtIsv)) return false;
+		string dxtLongDir = root + "/dxtLong";
+		writeDXTFrames(dxtLongDir, "d_%05d.dxt", 0, 500);
+		dxtLongIsv = root + "/dxtLong.isv";
+		return ofxImageSequenceVideo::packImageSequence(dxtLongDir, dxtLongIsv);
+	}
+
+	void remove(){
+		std::error_code ec;
+		std::filesystem::remove_all(root, ec);
+	}
+
+	//loads (or queues) one of the test sequences, at random
+	bool loadRandom(CheckedPlayer & player, bool queue, bool dxt){
+		if(dxt){
+			const string & path = rand() % 2 ? dxtDir : dxtIsv;
+			return queue ? player.queueNextSequence(path, 60) : player.loadImageSequence(path, 60);
+		}
+		switch(rand() % 5){
+			case 0: return queue ? player.queueNextSequence(dirA, 60) : player.loadImageSequence(dirA, 60);
+			case 1: return queue ? player.queueNextSequence(dirB, 60) : player.loadImageSequence(dirB, 60);
+			case 2: return queue ? player.queueNextSequence(isv, 60) : player.loadImageSequence(isv, 60);
+			case 3: return queue ? player.queueNextSequence(pattern, patternFirst, patternLast, 60) :
+								   player.loadImageSequence(pattern, patternFirst, patternLast, 60);
+			default: return queue ? player.queueNextSequence(chunks, 60) : player.loadImageSequence(chunks, 60);
+		}
+	}
+
+protected:
+
+	int nextTag = 1;
+
+	static string formatPath(const string & pattern, int i){
+		char path[1024];
+		snprintf(path, sizeof(path), pattern.c_str(), i);
+		return path;
+	}
+	void writeFrame(const string & path, bool decodable){
+		unsigned char tag[3] = {(unsigned char)(nextTag >> 16), (unsigned char)(nextTag >> 8), (unsigned char)nextTag};
+		nextTag++;
+		std::ofstream f(path, std::ios::binary | std::ios::trunc);
+		f.write((const char*)tag, decodable ? 3 : 1);
+	}
+	void writeFrames(const string & dir, const string & namePattern, int first, int count){
+		std::filesystem::create_directories(dir);
+		for(int i = first; i < first + count; i++){
+			writeFrame(dir + "/" + formatPath(namePattern, i), true);
+		}
+	}
+	void writeDXTFrames(const string & dir, const string & namePattern, int first, int count){ //4x4 DXT5, one block
+		std::filesystem::create_directories(dir);
+		for(int i = first; i < first + count; i++){
+			ofxDXT::Data frame;
+			frame.width = frame.height = 4;
+			frame.type = ofxDXT::DXT5;
+			frame.bytes = {(unsigned char)(nextTag >> 16), (unsigned char)(nextTag >> 8), (unsigned char)nextTag};
+			frame.bytes.resize(16);
+			nextTag++;
+			ofxDXT::saveToDisk(frame, dir + "/" + formatPath(namePattern, i));
+		}
+	}
+};
+
+static size_t getRssKb(){
+	#if defined(__linux__)
+	std::ifstream statm("/proc/self/statm");
+	size_t size = 0, resident = 0;
+	statm >> size >> resident;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+	#else
+	return 0;
+	#endif
+}
+
+static void setupPlayer(CheckedPlayer & player, const string & mode){
+	if(mode == "pipeline") player.setPipelineThreads(2, 3);
+	if(mode == "shared") player.setUseSharedScheduler(true);
+	if(mode == "uring") player.setUseIoUring(true); //falls back to the I/O threads without USE_IO_URING
+	player.setup(mode == "immediate" ? 0 : 3, 8, mode == "dxt");
+	player.setLoop(true);
+}
+
+//========================================================================
+static bool stressReload(TestData & data, float seconds, const string & mode){
+
+	CheckedPlayer player;
+	setupPlayer(player, mode);
+	bool dxt = mode == "dxt";
+	player.loadImageSequence(dxt ? data.dxtDir : data.dirA, 60);
+	player.play();
+
+	int numUpdates = 0, numReloads = 0, peakTables = 0;
+	size_t startRss = 0;
+	string error;
+	uint64_t start = ofGetElapsedTimeMicros();
+	uint64_t end = start + uint64_t(seconds * 1000000);
+
+	while(ofGetElapsedTimeMicros() < end){
+		int r = rand() % 100;
+		if(r < 30){
+			data.loadRandom(player, false, dxt);
+			numReloads++;
+		}else if(r < 35){
+			data.loadRandom(player, true, dxt);
+		}else if(r < 37){
+			player.clearQueuedSequence();
+		}else if(r < 38){
+			if(dxt){
+				player.setPlaylist({data.dxtDir, data.dxtIsv, data.dxtDir}, 60, true);
+			}else{
+				player.setPlaylist({data.dirA, data.isv, data.dirB}, 60, true);
+			}
+			numReloads++;
+		}else if(r < 45){
+			player.seekToFrame(rand() % MAX(1, player.getNumFrames()));
+		}else if(r < 48){
+			player.setPlaybackSpeed((rand() % 7 - 3) * 0.5f);
+		}else if(r < 50){
+			player.setPrerollFrames(rand() % 10);
+		}
+		player.trackTables();
+
+		player.update(1.0f / 60);
+		player.trackTables();
+		if(!player.checkCurrentPixels(error)) break;
+		numUpdates++;
+		peakTables = MAX(peakTables, player.getNumLiveTables());
+		if(numUpdates == 200) startRss = getRssKb(); //after warming up, pools and free lists are filled by now
+		std::this_thread::sleep_for(std::chrono::microseconds(300));
+	}
+	float elapsed = (ofGetElapsedTimeMicros() - start) / 1000000.0f;
+
+	//let the tasks that were in flight finish, their tables should go with them
+	player.setPlaybackSpeed(1);
+	for(int i = 0; i < 500 && error.empty(); i++){
+		player.update(1.0f / 60);
+		player.trackTables();
+		player.checkCurrentPixels(error);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	int staleTables = player.getNumStaleTables();
+
+	std::cout << "reload (" << mode << "): " << numReloads << " reloads in " << ofToString(elapsed, 1) << "s ("
+			  << int(numReloads / elapsed) << "/s), " << numUpdates << " updates, " << player.getNumChecks() << " frames checked"
+			  << std::endl;
+	std::cout << "  frame tables alive: peak " << peakTables << ", after settling " << player.getNumLiveTables()
+			  << " (" << staleTables << " stale); RSS " << startRss << " -> " << getRssKb() << " KB" << std::endl;
+
+	if(error.size()){
+		std::cout << "  FAILED: " << error << std::endl;
+		return false;
+	}
+	if(staleTables > 0){
+		std::cout << "  FAILED: frame tables of replaced sequences are still alive" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//========================================================================
+static bool stressSeek(TestData & data, float seconds, const string & mode){
+
+	CheckedPlayer player;
+	setupPlayer(player, mode);
+	player.loadImageSequence(mode == "dxt" ? data.dxtLongIsv : data.longDir, 60);
+	player.play();
+
+	int numUpdates = 0, numSeeks = 0;
+	bool playing = true, hold = false;
+	string error;
+	uint64_t start = ofGetElapsedTimeMicros();
+	uint64_t end = start + uint64_t(seconds * 1000000);
+	int numFrames = player.getNumFrames();
+
+	while(ofGetElapsedTimeMicros() < end){
+		int r = rand() % 100;
+		bool seeked = true;
+		if(r < 25){
+			player.seekToFrame(rand() % numFrames);
+		}else if(r < 30){ //near the playhead, so that some of the buffer survives
+			player.seekToFrame(player.getCurrentFrame() + rand() % 21 - 10);
+		}else if(r < 34){
+			player.setPosition(rand() / float(RAND_MAX));
+		}else if(r < 38){
+			player.advanceOneFrame();
+		}else{
+			seeked = false;
+			if(r < 42){
+				player.setPlaybackSpeed((rand() % 13 - 6) * 0.5f);
+			}else if(r < 44){
+				playing = !playing;
+				if(playing) player.play(); else player.pause();
+			}else if(r < 45){
+				hold = !hold;
+				player.setHoldPlaybackWhenFramesArentReady(hold);
+			}else if(r < 46){
+				player.setLoop(rand() % 4 != 0);
+			}
+		}
+		if(seeked){
+			numSeeks++;
+			if(!player.checkAllPixels(error)) break;
+		}
+
+		player.update((8 + rand() % 25) / 1000.0f); //30..120 fps, jittery
+		if(!player.checkAllPixels(error)) break;
+		numUpdates++;
+		std::this_thread::sleep_for(std::chrono::microseconds(rand() % 600));
+	}
+	float elapsed = (ofGetElapsedTimeMicros() - start) / 1000000.0f;
+
+	//pause and let the buffer fill up, then nothing should be left half way
+	player.pause();
+	player.setPlaybackSpeed(1);
+	for(int i = 0; i < 300 && error.empty(); i++){
+		player.update(1.0f / 60);
+		player.checkAllPixels(error);
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+	if(error.empty()) player.checkSettled(error);
+
+	std::cout << "seek (" << mode << "): " << numSeeks << " seeks in " << ofToString(elapsed, 1) << "s ("
+			  << int(numSeeks / elapsed) << "/s), " << numUpdates << " updates, " << player.getNumChecks() << " frames checked"
+			  << std::endl;
+
+	if(error.size()){
+		std::cout << "  FAILED: " << error << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//========================================================================
+static bool soak(TestData & data, float seconds, const string & mode){
+
+	ofStubFrameWidth = 1920;
+	ofStubFrameHeight = 1080;
+	CheckedPlayer player;
+	setupPlayer(player, mode);
+	player.setOutputPixelFormat(OF_PIXELS_RGB); //what the decoder outputs already
+	const size_t ramBudget = 128 * 1024 * 1024;
+	player.setMemoryBudget(ramBudget, 0);
+	player.loadImageSequence(data.longDir, 60);
+	player.play();
+
+	const int warmupSeconds = 2; //pools and free lists fill up
+	uint64_t start = ofGetElapsedTimeMicros();
+	uint64_t lastReport = start;
+	uint64_t lastAllocs = 0, lastReuses = 0, warmAllocs = 0;
+	size_t peakRamUse = 0;
+	int second = 0;
+	std::cout << "soak (" << mode << "):\n  sec  allocs/s  recycled/s  buffer  ramUse(MB)  RSS(MB)" << std::endl;
+
+	while(second < seconds){
+		player.update(1.0f / 60);
+		peakRamUse = MAX(peakRamUse, player.getRamUse());
+		std::this_thread::sleep_for(std::chrono::microseconds(16666));
+
+		uint64_t now = ofGetElapsedTimeMicros();
+		if(now - lastReport >= 1000000){
+			second++;
+			lastReport = now;
+			uint64_t allocs = player.getNumPixelAllocations();
+			uint64_t reuses = player.getNumPixelReuses();
+			std::cout << "  " << std::setw(3) << second << std::setw(10) << allocs - lastAllocs << std::setw(12) << reuses - lastReuses
+					  << std::setw(8) << player.getNumBufferFrames()
+					  << std::setw(12) << ofToString(player.getRamUse() / (1024.0f * 1024.0f), 1)
+					  << std::setw(9) << ofToString(getRssKb() / 1024.0f, 1) << std::endl;
+			if(second > warmupSeconds) warmAllocs += allocs - lastAllocs;
+			lastAllocs = allocs;
+			lastReuses = reuses;
+		}
+	}
+
+	std::cout << "  peak RAM use " << ofToString(peakRamUse / (1024.0f * 1024.0f), 1) << " MB, budget "
+			  << ramBudget / (1024 * 1024) << " MB" << std::endl;
+	if(warmAllocs > 0){
+		std::cout << "  FAILED: " << warmAllocs << " frame buffers allocated after warming up" << std::endl;
+		return false;
+	}
+	if(peakRamUse > ramBudget){
+		std::cout << "  FAILED: over the RAM budget" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//========================================================================
+static bool timeUpdates(TestData & data, float seconds, const string & mode){
+
+	auto percentile = [](vector<float> & v, float p){
+		if(v.empty()) return 0.0f;
+		std::sort(v.begin(), v.end());
+		return v[MIN(v.size() - 1, size_t(p * v.size()))];
+	};
+
+	std::cout << "update (" << mode << "), per player per call:\n"
+			  << "  players  update(us) avg/p99  cleanup(us) avg/p99  collected/s  all players(ms/frame)" << std::endl;
+	for(int numPlayers : {1, 4, 16, 64}){
+		vector<std::unique_ptr<CheckedPlayer>> players;
+		for(int i = 0; i < numPlayers; i++){
+			players.emplace_back(std::make_unique<CheckedPlayer>());
+			setupPlayer(*players.back(), mode);
+			players.back()->loadImageSequence(i % 2 ? data.dirA : data.longDir, 60);
+			players.back()->seekToFrame(rand() % players.back()->getNumFrames()); //not all in lockstep
+			players.back()->play();
+		}
+
+		vector<float> updateTimes, cleanupTimes;
+		uint64_t numCollected = 0, numFrames = 0;
+		double frameTime = 0;
+		uint64_t start = ofGetElapsedTimeMicros();
+		uint64_t end = start + uint64_t(seconds * 1000000 / 4);
+		uint64_t warmup = start + 500000; //buffers fill up
+		while(ofGetElapsedTimeMicros() < end){
+			uint64_t frameStart = ofGetElapsedTimeMicros();
+			bool warm = frameStart > warmup;
+			for(auto & p : players){
+				uint64_t t0 = ofGetElapsedTimeMicros();
+				int n = p->collectFinishedLoads();
+				uint64_t t1 = ofGetElapsedTimeMicros();
+				p->update(1.0f / 60);
+				uint64_t t2 = ofGetElapsedTimeMicros();
+				if(warm){
+					cleanupTimes.push_back(t1 - t0);
+					updateTimes.push_back(t2 - t0);
+					numCollected += n;
+				}
+			}
+			uint64_t elapsed = ofGetElapsedTimeMicros() - frameStart;
+			if(warm){
+				frameTime += elapsed;
+				numFrames++;
+			}
+			if(elapsed < 16666) std::this_thread::sleep_for(std::chrono::microseconds(16666 - elapsed));
+		}
+		float warmSeconds = (end - warmup) / 1000000.0f;
+		auto avg = [](const vector<float> & v){ float sum = 0; for(float f : v) sum += f; return v.size() ? sum / v.size() : 0.0f; };
+		float updateAvg = avg(updateTimes), cleanupAvg = avg(cleanupTimes);
+		std::cout << "  " << std::setw(7) << numPlayers
+				  << std::setw(12) << ofToString(updateAvg, 1) << " / " << std::setw(6) << ofToString(percentile(updateTimes, 0.99f), 0)
+				  << std::setw(13) << ofToString(cleanupAvg, 1) << " / " << std::setw(6) << ofToString(percentile(cleanupTimes, 0.99f), 0)
+				  << std::setw(13) << int(numCollected / warmSeconds)
+				  << std::setw(23) << ofToString(numFrames ? frameTime / numFrames / 1000.0 : 0.0, 2) << std::endl;
+	}
+	return true;
+}
+
+//========================================================================
+int main(int argc, char ** argv){
+
+	string usage = "usage: isvStress reload [seconds] [threads|pipeline|shared|uring|immediate|dxt] [seed]\n"
+				   "       isvStress seek [seconds] [threads|pipeline|shared|uring|dxt] [seed]\n"
+				   "       isvStress soak [seconds] [threads|pipeline|shared|uring]\n"
+				   "       isvStress update [seconds] [threads|pipeline|shared|uring]";
+	if(argc < 2){
+		std::cerr << usage << std::endl;
+		return 1;
+	}
+	string test = argv[1];
+	float seconds = argc > 2 ? atof(argv[2]) : 10.0f;
+	string mode = argc > 3 ? argv[3] : "threads";
+	unsigned int seed = argc > 4 ? atoi(argv[4]) : (unsigned int)time(nullptr);
+	if(mode != "threads" && mode != "pipeline" && mode != "shared" && mode != "uring" && mode != "immediate" && mode != "dxt"){
+		std::cerr << usage << std::endl;
+		return 1;
+	}
+	std::cout << "seed " << seed << std::endl;
+	srand(seed);
+
+	TestData data;
+	if(!data.create()){
+		std::cerr << "can't create the test sequences in \"" << data.root << "\"" << std::endl;
+		data.remove();
+		return 1;
+	}
+
+	bool ok;
+	if(test == "reload"){
+		ok = stressReload(data, seconds, mode);
+	}else if(test == "seek" && mode != "immediate"){ //seeks in immediate mode load right away, there's no threading to check
+		ok = stressSeek(data, seconds, mode);
+	}else if(test == "soak" && mode != "immediate" && mode != "dxt"){ //no pool in immediate mode, nor for DXT
+		ok = soak(data, seconds, mode);
+	}else if(test == "update" && mode != "immediate"){ //nothing is collected in immediate mode
+		ok = timeUpdates(data, seconds, mode);
+	}else{
+		std::cerr << usage << std::endl;
+		ok = false;
+	}
+	data.remove();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+//
+//  ofMain.h - minimal openFrameworks stand in, just enough to build and run ofxImageSequenceVideo headless (no GL,
+//  no FreeImage) for isvStress. Not a general purpose OF replacement.
+//
+//  ofLoadImage() is a fake decoder: a "frame" file holds a 3 byte tag, and decodes into ofStubFrameWidth x
+//  ofStubFrameHeight (4x4 by default) RGB pixels filled with it, after sleeping ofStubDecodeMicros (to stand in for the
+//  decode time). Files shorter than that fail to decode.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <deque>
+#include <chrono>
+
+using namespace std;
+
+//as ofConstants.h does
+#if defined(_WIN32)
+	#define TARGET_WIN32
+#elif defined(__APPLE__)
+	#define TARGET_OSX
+#elif defined(__linux__)
+	#define TARGET_LINUX
+#endif
+
+#ifndef MAX
+	#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+	#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+enum ofPixelFormat{
+	OF_PIXELS_GRAY = 0,
+	OF_PIXELS_GRAY_ALPHA,
+	OF_PIXELS_RGB,
+	OF_PIXELS_BGR,
+	OF_PIXELS_RGBA,
+	OF_PIXELS_BGRA,
+	OF_PIXELS_UNKNOWN = -1
+};
+
+class ofPixels{
+public:
+	void allocate(size_t w, size_t h, ofPixelFormat f){
+		if(w == width && h == height && f == format && data.size()) return;
+		width = w; height = h; format = f;
+		data.resize(w * h * getNumChannels());
+	}
+	void allocate(size_t w, size_t h, size_t numChannels){
+		allocate(w, h, numChannels == 4 ? OF_PIXELS_RGBA : numChannels == 3 ? OF_PIXELS_RGB :
+					   numChannels == 2 ? OF_PIXELS_GRAY_ALPHA : OF_PIXELS_GRAY);
+	}
+	void setFromExternalPixels(unsigned char * p, size_t w, size_t h, ofPixelFormat f){
+		allocate(w, h, f);
+		std::copy(p, p + data.size(), data.begin());
+	}
+	unsigned char * getData(){ return data.size() ? data.data() : nullptr; }
+	const unsigned char * getData() const { return data.size() ? data.data() : nullptr; }
+	bool isAllocated() const { return data.size() > 0; }
+	size_t getWidth() const { return width; }
+	size_t getHeight() const { return height; }
+	size_t getNumChannels() const {
+		switch(format){
+			case OF_PIXELS_GRAY: return 1;
+			case OF_PIXELS_GRAY_ALPHA: return 2;
+			case OF_PIXELS_RGB: case OF_PIXELS_BGR: return 3;
+			case OF_PIXELS_RGBA: case OF_PIXELS_BGRA: return 4;
+			default: return 0;
+		}
+	}
+	size_t getNumPlanes() const { return getNumChannels(); }
+	size_t getTotalBytes() const { return data.size(); }
+	size_t size() const { return data.size(); }
+	size_t getBytesStride() const { return width * getNumChannels(); }
+	ofPixelFormat getPixelFormat() const { return format; }
+	void swap(ofPixels & o){ std::swap(data, o.data); std::swap(width, o.width); std::swap(height, o.height); std::swap(format, o.format); }
+	void clear(){ data.clear(); data.shrink_to_fit(); width = height = 0; format = OF_PIXELS_UNKNOWN; }
+	void resize(size_t, size_t){}
+	void resizeTo(ofPixels &) const {}
+	void setImageType(int){}
+	void setNumChannels(int){}
+
+protected:
+	std::vector<unsigned char> data;
+	size_t width = 0;
+	size_t height = 0;
+	ofPixelFormat format = OF_PIXELS_UNKNOWN;
+};
+
+class ofBuffer{
+public:
+	ofBuffer(){}
+	ofBuffer(const char * d, size_t s) : bytes(d, d + s){}
+	void set(const char * d, size_t s){ bytes.assign(d, d + s); }
+	char * getData(){ return bytes.data(); }
+	const char * getData() const { return bytes.data(); }
+	size_t size() const { return bytes.size(); }
+	void allocate(size_t s){ bytes.resize(s); }
+	void resize(size_t s){ bytes.resize(s); }
+	void reserve(size_t s){ bytes.reserve(s); }
+	void clear(){ bytes.clear(); }
+
+protected:
+	std::vector<char> bytes;
+};
+
+inline ofBuffer ofBufferFromFile(const string & path, bool){
+	std::ifstream f(path, std::ios::binary | std::ios::ate);
+	ofBuffer b;
+	if(!f) return b;
+	b.allocate(f.tellg());
+	f.seekg(0);
+	f.read(b.getData(), b.size());
+	return b;
+}
+
+//just enough GL for compressed uploads, which do nothing
+typedef int GLint;
+typedef int GLsizei;
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_RGBA 0x1908
+#define GL_UNSIGNED_BYTE 0x1401
+inline void glBindTexture(int, unsigned int){}
+inline void glCompressedTexSubImage2D(int, int, int, int, int, int, int, GLsizei, const void *){}
+
+struct ofTextureData{
+	int glInternalFormat = 0;
+	int textureTarget = 0;
+	unsigned int textureID = 0;
+	float width = 0, height = 0, tex_w = 0, tex_h = 0, tex_t = 0, tex_u = 0;
+};
+
+class ofTexture{ //no GL, uploads do nothing
+public:
+	void loadData(const ofPixels &){}
+	void allocate(int, int, int){}
+	void allocate(const ofTextureData & data, int, int){ texData = data; }
+	void clear(){}
+	bool isAllocated() const { return true; }
+	float getWidth() const { return 0; }
+	float getHeight() const { return 0; }
+	ofTextureData & getTextureData(){ return texData; }
+	void draw(float, float, float, float) const {}
+
+protected:
+	ofTextureData texData;
+};
+
+inline int ofGetNumChannelsFromGLFormat(int){ return 4; }
+
+//logs go to stderr, only if OFLOG is set in the environment
+struct ofLogStream{
+	ofLogStream(){}
+	ofLogStream(const string & module) : module(module){}
+	~ofLogStream(){ if(getenv("OFLOG")) std::cerr << "[" << module << "] " << ss.str() << std::endl; }
+	template<class T> ofLogStream & operator<<(const T & v){ ss << v; return *this; }
+	std::ostringstream ss;
+	string module;
+};
+typedef ofLogStream ofLogError;
+typedef ofLogStream ofLogWarning;
+typedef ofLogStream ofLogNotice;
+typedef ofLogStream ofLogVerbose;
+
+template<class T> string ofToString(const T & v){ std::ostringstream s; s << v; return s.str(); }
+template<class T> string ofToString(const T & v, int precision){ std::ostringstream s; s << std::fixed << std::setprecision(precision) << v; return s.str(); }
+inline string ofToLower(const string & s){ string r = s; for(auto & c : r) c = tolower((unsigned char)c); return r; }
+inline float ofLerp(float a, float b, float t){ return a + (b - a) * t; }
+inline float ofClamp(float v, float a, float b){ return v < a ? a : v > b ? b : v; }
+inline float ofRandom(float max){ return max * rand() / float(RAND_MAX); }
+inline string ofToDataPath(const string & path, bool = false){ return path; }
+
+struct ofFilePath{
+	static string getFileExt(const string & s){ auto p = s.rfind('.'); return p == string::npos ? "" : s.substr(p + 1); }
+	static string getFileName(const string & s){ auto p = s.find_last_of("/\\"); return p == string::npos ? s : s.substr(p + 1); }
+};
+
+inline uint64_t ofGetElapsedTimeMicros(){
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+inline uint64_t ofGetFrameNum(){ return 0; }
+inline void ofSleepMillis(int ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+template<class T> struct ofFastEvent{
+	std::function<void(T &)> callback; //a single listener is enough here
+};
+template<class E, class T, class S> void ofNotifyEvent(E & e, T & args, S *){ if(e.callback) e.callback(args); }
+template<class E, class T> void ofNotifyEvent(E & e, T & args){ if(e.callback) e.callback(args); }
+
+//fake decoder, see the top of this file
+inline std::atomic<int> ofStubDecodeMicros{300};
+inline std::atomic<int> ofStubFrameWidth{4};
+inline std::atomic<int> ofStubFrameHeight{4};
+
+inline bool ofLoadImage(ofPixels & pix, const ofBuffer & buffer){
+	std::this_thread::sleep_for(std::chrono::microseconds(ofStubDecodeMicros.load()));
+	if(buffer.size() < 3) return false;
+	pix.allocate(ofStubFrameWidth, ofStubFrameHeight, OF_PIXELS_RGB);
+	unsigned char * p = pix.getData();
+	memcpy(p, buffer.getData(), 3);
+	for(size_t filled = 3; filled < pix.size(); filled *= 2){ //keeps repeating the tag
+		memcpy(p + filled, p, MIN(filled, pix.size() - filled));
+	}
+	return true;
+}
+
+inline bool ofLoadImage(ofPixels & pix, const string & path){
+	ofBuffer buffer = ofBufferFromFile(path, true);
+	return ofLoadImage(pix, buffer);
+}
+
+struct ofColor{
+	ofColor(int gray = 0) : r(gray), g(gray), b(gray), a(255){}
+	ofColor(int r, int g, int b, int a = 255) : r(r), g(g), b(b), a(a){}
+	unsigned char r, g, b, a;
+	static const ofColor orange;
+};
+inline const ofColor ofColor::orange(255, 165, 0);
+
+namespace glm{
+	struct vec3{
+		vec3(float x, float y, float z) : x(x), y(y), z(z){}
+		float x, y, z;
+	};
+}
+
+enum ofPrimitiveMode{ OF_PRIMITIVE_POINTS };
+struct ofMesh{
+	void setMode(ofPrimitiveMode){}
+	void addColor(ofColor){}
+	void addVertex(glm::vec3){}
+	void draw(){}
+};
+
+//drawing does nothing
+inline void ofSetColor(int, int = 255){}
+inline void ofSetColor(int, int, int, int = 255){}
+inline void ofSetColor(const ofColor &){}
+inline void ofPushMatrix(){}
+inline void ofPopMatrix(){}
+inline void ofTranslate(float, float){}
+inline void ofDrawRectangle(float, float, float, float){}
+inline void ofDrawTriangle(float, float, float, float, float, float){}
+inline void glPointSize(float){}
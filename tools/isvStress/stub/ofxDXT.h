@@ -0,0 +1,48 @@
+//
+//  ofxDXT.h - stand in for the ofxDXT addon, see ofMain.h. Its .dxt "files" are a 12 byte header (width, height and
+//  compression type, int32 each) followed by the blocks - not ofxDXT's real file format. Nothing is compressed.
+//
+
+#pragma once
+#include "ofMain.h"
+
+namespace ofxDXT{
+
+	enum Type{ DXT1, DXT3, DXT5 };
+
+	struct Data{
+		unsigned char * getData(){ return bytes.data(); }
+		const unsigned char * getData() const { return bytes.data(); }
+		size_t size() const { return bytes.size(); }
+		int getWidth() const { return width; }
+		int getHeight() const { return height; }
+		Type getCompressionType() const { return type; }
+
+		std::vector<unsigned char> bytes;
+		int width = 0;
+		int height = 0;
+		Type type = DXT1;
+	};
+
+	inline bool loadFromDisk(const string & path, Data & data){
+		ofBuffer buffer = ofBufferFromFile(path, true);
+		if(buffer.size() < 12) return false;
+		int32_t header[3];
+		memcpy(header, buffer.getData(), 12);
+		data.width = header[0];
+		data.height = header[1];
+		data.type = (Type)header[2];
+		data.bytes.assign(buffer.getData() + 12, buffer.getData() + buffer.size());
+		return true;
+	}
+
+	inline bool saveToDisk(const Data & data, const string & path){
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		int32_t header[3] = {data.width, data.height, (int32_t)data.type};
+		out.write((const char *)header, 12);
+		out.write((const char *)data.getData(), data.size());
+		return !out.fail();
+	}
+
+	inline void loadDataIntoTexture(Data &, ofTexture &){}
+}
@@ -0,0 +1,9 @@
+//
+//  ofxTimeMeasurements.h - stand in for the ofxTimeMeasurements addon, see ofMain.h
+//
+
+#pragma once
+
+#define TS_START_ACC(x)
+#define TS_STOP_ACC(x)
+#define TS_SCOPE(x)